@@ -18,11 +18,11 @@
 class ClientAgentInteraction : public ::testing::TestWithParam<std::tuple<TransportKind, MiddlewareKind>>
 {
 public:
-    const uint16_t AGENT_PORT = 2018;
     const float LOST = 0.1f;
 
     ClientAgentInteraction()
         : transport_(std::get<0>(GetParam()))
+        , agent_port_(get_free_port(transport_))
         , fd_{-1}
         , middleware_{}
         , client_(0.0f, 8)
@@ -36,7 +36,8 @@ public:
                 middleware_ = eprosima::uxr::Middleware::Kind::CED;
                 break;
         }
-        init_agent(AGENT_PORT);
+        init_agent(agent_port_);
+        client_.set_topic_suffix(get_topic_suffix());
     }
 
     ~ClientAgentInteraction() override
@@ -54,7 +55,7 @@ public:
             {
                 UDPTransportInfo transport_info;
                 transport_info.ip = "127.0.0.1";
-                transport_info.port = AGENT_PORT;
+                transport_info.port = agent_port_;
                 ASSERT_NO_FATAL_FAILURE(client_.init_transport<UDPTransportInfo>(transport_info));
                 break;
             }
@@ -62,7 +63,7 @@ public:
             {
                 TCPTransportInfo transport_info;
                 transport_info.ip = "127.0.0.1";
-                transport_info.port = AGENT_PORT;
+                transport_info.port = agent_port_;
                 ASSERT_NO_FATAL_FAILURE(client_.init_transport<TCPTransportInfo>(transport_info));
                 break;
             }
@@ -133,6 +134,7 @@ public:
 
 protected:
     TransportKind transport_;
+    uint16_t agent_port_;
     int fd_;
     eprosima::uxr::Middleware::Kind middleware_;
     std::unique_ptr<eprosima::uxr::Server> agent_;
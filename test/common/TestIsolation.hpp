@@ -0,0 +1,117 @@
+#ifndef IN_TEST_TESTISOLATION_HPP
+#define IN_TEST_TESTISOLATION_HPP
+
+#include "TransportInfo.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <process.h>
+#else
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Helpers which let the integration tests run in parallel, each one of them with its own agent on
+ * its own port and on its own topics.
+ */
+
+/*
+ * Port of the loopback interface which is free for the given transport, picked by the system as
+ * for any ephemeral bind. The probing socket is closed on return, so the port is not reserved: it
+ * may be taken by another process before the agent of the test binds it. Returns 0 on failure.
+ */
+inline uint16_t get_free_port(TransportKind kind)
+{
+#ifdef _WIN32
+    WSADATA wsa_data;
+    if(0 != WSAStartup(MAKEWORD(2, 2), &wsa_data))
+    {
+        return 0;
+    }
+    SOCKET fd = socket(AF_INET, (TransportKind::tcp == kind) ? SOCK_STREAM : SOCK_DGRAM, 0);
+    bool valid = (INVALID_SOCKET != fd);
+#else
+    int fd = socket(AF_INET, (TransportKind::tcp == kind) ? SOCK_STREAM : SOCK_DGRAM, 0);
+    bool valid = (-1 != fd);
+#endif
+
+    uint16_t port = 0;
+    if(valid)
+    {
+        struct sockaddr_in address = {};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        address.sin_port = 0;
+#ifdef _WIN32
+        int length = sizeof(address);
+#else
+        socklen_t length = sizeof(address);
+#endif
+        if(0 == bind(fd, reinterpret_cast<struct sockaddr*>(&address), sizeof(address))
+            && 0 == getsockname(fd, reinterpret_cast<struct sockaddr*>(&address), &length))
+        {
+            port = ntohs(address.sin_port);
+        }
+    }
+
+#ifdef _WIN32
+    if(valid)
+    {
+        closesocket(fd);
+    }
+    WSACleanup();
+#else
+    if(valid)
+    {
+        close(fd);
+    }
+#endif
+    return port;
+}
+
+/*
+ * Suffix of the topics of a test, unique among the tests of every process of the host, so that
+ * the DDS entities of tests running at once never match each other.
+ */
+inline std::string get_topic_suffix()
+{
+    static std::atomic<uint32_t> next_suffix(0);
+#ifdef _WIN32
+    int pid = _getpid();
+#else
+    int pid = int(getpid());
+#endif
+    return "_" + std::to_string(pid) + "_" + std::to_string(next_suffix++);
+}
+
+/*
+ * The XML representation with the suffix appended to every occurrence of the topic name.
+ */
+inline std::string with_topic_suffix(
+        const char* xml,
+        const char* topic_name,
+        const std::string& suffix)
+{
+    std::string result(xml);
+    std::string name(topic_name);
+    if(suffix.empty() || name.empty())
+    {
+        return result;
+    }
+
+    for(size_t pos = result.find(name); std::string::npos != pos; pos = result.find(name, pos))
+    {
+        pos += name.size();
+        result.insert(pos, suffix);
+        pos += suffix.size();
+    }
+    return result;
+}
+
+#endif // IN_TEST_TESTISOLATION_HPP
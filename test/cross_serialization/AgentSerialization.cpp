@@ -309,6 +309,11 @@ std::vector<uint8_t> AgentSerialization::read_data_payload()
 }
 
 std::vector<uint8_t> AgentSerialization::write_data_payload_data()
+{
+    return write_data_payload_data({'B', 'Y', 'T', 'E', 'S'});
+}
+
+std::vector<uint8_t> AgentSerialization::write_data_payload_data(const std::vector<uint8_t>& data)
 {
     /* Header. */
     dds::xrce::MessageHeader header = generate_message_header();
@@ -317,7 +322,7 @@ std::vector<uint8_t> AgentSerialization::write_data_payload_data()
     dds::xrce::WRITE_DATA_Payload_Data payload;
     payload.request_id() = {0x01, 0x23};
     payload.object_id() = {0x45, 0x67};
-    payload.data().serialized_data() = {'B', 'Y', 'T', 'E', 'S'};
+    payload.data().serialized_data() = data;
 
     /* Subheader. */
     dds::xrce::SubmessageHeader subheader;
@@ -341,29 +346,30 @@ std::vector<uint8_t> AgentSerialization::write_data_payload_data()
 
 std::vector<uint8_t> AgentSerialization::write_data_payload_sample()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::SAMPLE));
 }
 
 std::vector<uint8_t> AgentSerialization::write_data_payload_data_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::DATA_SEQ));
 }
 
 std::vector<uint8_t> AgentSerialization::write_data_payload_sample_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::SAMPLE_SEQ));
 }
 
 std::vector<uint8_t> AgentSerialization::write_data_payload_packed_samples()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::PACKED_SAMPLES));
 }
 
 std::vector<uint8_t> AgentSerialization::data_payload_data()
+{
+    return data_payload_data({'B', 'Y', 'T', 'E', 'S'});
+}
+
+std::vector<uint8_t> AgentSerialization::data_payload_data(const std::vector<uint8_t>& data)
 {
     /* Header. */
     dds::xrce::MessageHeader header = generate_message_header();
@@ -372,7 +378,7 @@ std::vector<uint8_t> AgentSerialization::data_payload_data()
     dds::xrce::DATA_Payload_Data payload;
     payload.request_id() = {0x01, 0x23};
     payload.object_id() = {0x45, 0x67};
-    payload.data().serialized_data() = {'B', 'Y', 'T', 'E', 'S'};
+    payload.data().serialized_data() = data;
 
     /* Subheader. */
     dds::xrce::SubmessageHeader subheader;
@@ -396,26 +402,22 @@ std::vector<uint8_t> AgentSerialization::data_payload_data()
 
 std::vector<uint8_t> AgentSerialization::data_payload_sample()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::SAMPLE));
 }
 
 std::vector<uint8_t> AgentSerialization::data_payload_data_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::DATA_SEQ));
 }
 
 std::vector<uint8_t> AgentSerialization::data_payload_sample_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::SAMPLE_SEQ));
 }
 
 std::vector<uint8_t> AgentSerialization::data_payload_packed_samples()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::PACKED_SAMPLES));
 }
 
 std::vector<uint8_t> AgentSerialization::acknack_payload()
@@ -479,3 +481,317 @@ std::vector<uint8_t> AgentSerialization::heartbeat_payload()
 
     return buffer;
 }
+
+/*
+ * Payloads of the given values, each one in a message of its own.
+ */
+template<typename T>
+static std::vector<uint8_t> serialize_message(dds::xrce::SubmessageId submessage_id, const T& payload)
+{
+    /* Header. */
+    dds::xrce::MessageHeader header = generate_message_header();
+
+    /* Subheader. */
+    dds::xrce::SubmessageHeader subheader;
+    subheader.submessage_id(submessage_id);
+    subheader.flags(0x01);
+    subheader.submessage_length(uint16_t(payload.getCdrSerializedSize()));
+
+    /* Message size. */
+    size_t message_size = header.getCdrSerializedSize() +
+                          subheader.getCdrSerializedSize() +
+                          payload.getCdrSerializedSize();
+
+    eprosima::uxr::OutputMessage output(header, message_size);
+    output.append_submessage(submessage_id, payload, 0x0001);
+
+    std::vector<uint8_t> buffer;
+    buffer.assign(output.get_buf(), output.get_buf() + output.get_len());
+
+    return buffer;
+}
+
+template<typename T>
+static void set_base(T& payload, const BaseRequestValues& base)
+{
+    payload.request_id() = {base.request_id[0], base.request_id[1]};
+    payload.object_id() = {base.object_id[0], base.object_id[1]};
+}
+
+template<typename T>
+static void set_representation(T& representation, const CreateValues& values)
+{
+    switch(values.format)
+    {
+        case RepresentationFormat::BY_REFERENCE:
+            representation._d() = dds::xrce::REPRESENTATION_BY_REFERENCE;
+            representation.object_reference() = values.representation;
+            break;
+        case RepresentationFormat::AS_XML_STRING:
+            representation._d() = dds::xrce::REPRESENTATION_AS_XML_STRING;
+            representation.xml_string_representation() = values.representation;
+            break;
+        case RepresentationFormat::IN_BINARY:
+            representation._d() = dds::xrce::REPRESENTATION_IN_BINARY;
+            representation.binary_representation().assign(values.representation.begin(), values.representation.end());
+            break;
+    }
+}
+
+template<typename T>
+static void set_bin_and_xml_representation(T& representation, const CreateValues& values)
+{
+    if(RepresentationFormat::IN_BINARY == values.format)
+    {
+        representation._d() = dds::xrce::REPRESENTATION_IN_BINARY;
+        representation.binary_representation().assign(values.representation.begin(), values.representation.end());
+    }
+    else
+    {
+        representation._d() = dds::xrce::REPRESENTATION_AS_XML_STRING;
+        representation.string_representation() = values.representation;
+    }
+}
+
+template<typename T>
+static void set_ref_and_xml_representation(T& representation, const CreateValues& values)
+{
+    if(RepresentationFormat::BY_REFERENCE == values.format)
+    {
+        representation._d() = dds::xrce::REPRESENTATION_BY_REFERENCE;
+        representation.object_name() = values.representation;
+    }
+    else
+    {
+        representation._d() = dds::xrce::REPRESENTATION_AS_XML_STRING;
+        representation.xml_string_representation() = values.representation;
+    }
+}
+
+static dds::xrce::SampleInfo sample_info(const SampleInfoValues& values)
+{
+    dds::xrce::SampleInfo info;
+    info.state() = values.state;
+    info.sequence_number() = values.sequence_number;
+    info.session_time_offset() = values.session_time_offset;
+    return info;
+}
+
+static dds::xrce::SampleData sample_data(const std::vector<uint8_t>& data)
+{
+    dds::xrce::SampleData sample;
+    sample.serialized_data() = data;
+    return sample;
+}
+
+static dds::xrce::Sample sample(const DataValues& values, size_t index)
+{
+    dds::xrce::Sample sample;
+    sample.info() = sample_info(values.info[index]);
+    sample.data() = sample_data(values.data[index]);
+    return sample;
+}
+
+static dds::xrce::PackedSamples packed_samples(const DataValues& values)
+{
+    dds::xrce::PackedSamples packed;
+    packed.info() = sample_info(values.info[0]);
+    for(const auto& delta_values : values.deltas)
+    {
+        dds::xrce::SampleDelta delta;
+        delta.info_delta().state() = delta_values.state;
+        delta.info_delta().seq_number_delta() = delta_values.seq_number_delta;
+        delta.info_delta().timestamp_delta() = delta_values.timestamp_delta;
+        delta.data() = sample_data(delta_values.data);
+        packed.sample_delta_seq().push_back(delta);
+    }
+    return packed;
+}
+
+/*
+ * WRITE_DATA and DATA payloads of each format share their fields, hence their construction.
+ */
+template<typename Data, typename Sample, typename DataSeq, typename SampleSeq, typename PackedSamples>
+static std::vector<uint8_t> serialize_data_message(dds::xrce::SubmessageId submessage_id, const DataValues& values)
+{
+    switch(values.format)
+    {
+        case DataFormat::DATA:
+        {
+            Data payload;
+            set_base(payload, values.base);
+            payload.data() = sample_data(values.data[0]);
+            return serialize_message(submessage_id, payload);
+        }
+        case DataFormat::SAMPLE:
+        {
+            Sample payload;
+            set_base(payload, values.base);
+            payload.sample() = sample(values, 0);
+            return serialize_message(submessage_id, payload);
+        }
+        case DataFormat::DATA_SEQ:
+        {
+            DataSeq payload;
+            set_base(payload, values.base);
+            for(const auto& data : values.data)
+            {
+                payload.data_seq().push_back(sample_data(data));
+            }
+            return serialize_message(submessage_id, payload);
+        }
+        case DataFormat::SAMPLE_SEQ:
+        {
+            SampleSeq payload;
+            set_base(payload, values.base);
+            for(size_t i = 0; i < values.data.size(); ++i)
+            {
+                payload.sample_seq().push_back(sample(values, i));
+            }
+            return serialize_message(submessage_id, payload);
+        }
+        case DataFormat::PACKED_SAMPLES:
+        {
+            PackedSamples payload;
+            set_base(payload, values.base);
+            payload.packed_samples() = packed_samples(values);
+            return serialize_message(submessage_id, payload);
+        }
+    }
+    return std::vector<uint8_t>();
+}
+
+std::vector<uint8_t> AgentSerialization::create_payload(const CreateValues& values)
+{
+    dds::xrce::CREATE_Payload payload;
+    set_base(payload, values.base);
+    dds::xrce::ObjectId parent_id = {values.parent_id[0], values.parent_id[1]};
+    dds::xrce::ObjectVariant& variant = payload.object_representation();
+    switch(values.kind)
+    {
+        case ObjectKind::PARTICIPANT:
+            variant._d() = dds::xrce::OBJK_PARTICIPANT;
+            set_representation(variant.participant().representation(), values);
+            variant.participant().domain_id() = values.domain_id;
+            break;
+        case ObjectKind::TOPIC:
+            variant._d() = dds::xrce::OBJK_TOPIC;
+            set_representation(variant.topic().representation(), values);
+            variant.topic().participant_id() = parent_id;
+            break;
+        case ObjectKind::PUBLISHER:
+            variant._d() = dds::xrce::OBJK_PUBLISHER;
+            set_bin_and_xml_representation(variant.publisher().representation(), values);
+            variant.publisher().participant_id() = parent_id;
+            break;
+        case ObjectKind::SUBSCRIBER:
+            variant._d() = dds::xrce::OBJK_SUBSCRIBER;
+            set_bin_and_xml_representation(variant.subscriber().representation(), values);
+            variant.subscriber().participant_id() = parent_id;
+            break;
+        case ObjectKind::DATAWRITER:
+            variant._d() = dds::xrce::OBJK_DATAWRITER;
+            set_representation(variant.data_writer().representation(), values);
+            variant.data_writer().publisher_id() = parent_id;
+            break;
+        case ObjectKind::DATAREADER:
+            variant._d() = dds::xrce::OBJK_DATAREADER;
+            set_representation(variant.data_reader().representation(), values);
+            variant.data_reader().subscriber_id() = parent_id;
+            break;
+        case ObjectKind::TYPE:
+            variant._d() = dds::xrce::OBJK_TYPE;
+            set_representation(variant.type().representation(), values);
+            variant.type().participant_id() = parent_id;
+            variant.type().registered_type_name() = values.type_name;
+            break;
+        case ObjectKind::QOSPROFILE:
+            variant._d() = dds::xrce::OBJK_QOSPROFILE;
+            set_ref_and_xml_representation(variant.qos_profile().representation(), values);
+            break;
+        case ObjectKind::APPLICATION:
+            variant._d() = dds::xrce::OBJK_APPLICATION;
+            set_ref_and_xml_representation(variant.application().representation(), values);
+            break;
+        case ObjectKind::AGENT:
+        {
+            dds::xrce::AGENT_Representation agent;
+            agent.xrce_cookie({values.xrce_cookie[0], values.xrce_cookie[1], values.xrce_cookie[2], values.xrce_cookie[3]});
+            agent.xrce_version({values.xrce_version[0], values.xrce_version[1]});
+            agent.xrce_vendor_id({values.xrce_vendor_id[0], values.xrce_vendor_id[1]});
+            variant.agent(agent);
+            break;
+        }
+        case ObjectKind::CLIENT:
+        {
+            dds::xrce::CLIENT_Representation client;
+            client.xrce_cookie({values.xrce_cookie[0], values.xrce_cookie[1], values.xrce_cookie[2], values.xrce_cookie[3]});
+            client.xrce_version({values.xrce_version[0], values.xrce_version[1]});
+            client.xrce_vendor_id({values.xrce_vendor_id[0], values.xrce_vendor_id[1]});
+            client.client_key({values.client_key[0], values.client_key[1], values.client_key[2], values.client_key[3]});
+            client.session_id() = values.session_id;
+            client.mtu() = values.mtu;
+            variant.client(client);
+            break;
+        }
+    }
+    return serialize_message(dds::xrce::CREATE, payload);
+}
+
+std::vector<uint8_t> AgentSerialization::read_data_payload(const ReadDataValues& values)
+{
+    dds::xrce::READ_DATA_Payload payload;
+    set_base(payload, values.base);
+    payload.read_specification().preferred_stream_id() = values.preferred_stream_id;
+    payload.read_specification().data_format() = values.data_format;
+    if(values.has_filter)
+    {
+        payload.read_specification().content_filter_expression(values.filter);
+    }
+    if(values.has_delivery_control)
+    {
+        dds::xrce::DataDeliveryControl delivery_control;
+        delivery_control.max_samples() = values.max_samples;
+        delivery_control.max_elapsed_time() = values.max_elapsed_time;
+        delivery_control.max_bytes_per_second() = values.max_bytes_per_second;
+        delivery_control.min_pace_period() = values.min_pace_period;
+        payload.read_specification().delivery_control(delivery_control);
+    }
+    return serialize_message(dds::xrce::READ_DATA, payload);
+}
+
+std::vector<uint8_t> AgentSerialization::write_data_payload(const DataValues& values)
+{
+    return serialize_data_message<dds::xrce::WRITE_DATA_Payload_Data,
+                                  dds::xrce::WRITE_DATA_Payload_Sample,
+                                  dds::xrce::WRITE_DATA_Payload_DataSeq,
+                                  dds::xrce::WRITE_DATA_Payload_SampleSeq,
+                                  dds::xrce::WRITE_DATA_Payload_PackedSamples>(dds::xrce::WRITE_DATA, values);
+}
+
+std::vector<uint8_t> AgentSerialization::data_payload(const DataValues& values)
+{
+    return serialize_data_message<dds::xrce::DATA_Payload_Data,
+                                  dds::xrce::DATA_Payload_Sample,
+                                  dds::xrce::DATA_Payload_DataSeq,
+                                  dds::xrce::DATA_Payload_SampleSeq,
+                                  dds::xrce::DATA_Payload_PackedSamples>(dds::xrce::DATA, values);
+}
+
+std::vector<uint8_t> AgentSerialization::acknack_payload(const AcknackValues& values)
+{
+    dds::xrce::ACKNACK_Payload payload;
+    payload.first_unacked_seq_num() = values.first_unacked_seq_num;
+    payload.nack_bitmap() = {values.nack_bitmap[0], values.nack_bitmap[1]};
+    payload.stream_id() = values.stream_id;
+    return serialize_message(dds::xrce::ACKNACK, payload);
+}
+
+std::vector<uint8_t> AgentSerialization::heartbeat_payload(const HeartbeatValues& values)
+{
+    dds::xrce::HEARTBEAT_Payload payload;
+    payload.first_unacked_seq_nr() = values.first_unacked_seq_nr;
+    payload.last_unacked_seq_nr() = values.last_unacked_seq_nr;
+    payload.stream_id() = values.stream_id;
+    return serialize_message(dds::xrce::HEARTBEAT, payload);
+}
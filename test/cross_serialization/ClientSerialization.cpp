@@ -2,7 +2,9 @@
 
 #include <core/serialization/xrce_protocol_internal.h>
 #include <ucdr/microcdr.h>
+#include <algorithm>
 #include <cstring>
+#include <memory>
 
 #define BUFFER_LENGTH 1024
 
@@ -192,7 +194,12 @@ std::vector<uint8_t> ClientSerialization::read_data_payload()
 
 std::vector<uint8_t> ClientSerialization::write_data_payload_data()
 {
-    std::vector<uint8_t> buffer(BUFFER_LENGTH, 0x00);
+    return write_data_payload_data({'B', 'Y', 'T', 'E', 'S'});
+}
+
+std::vector<uint8_t> ClientSerialization::write_data_payload_data(const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> buffer(BUFFER_LENGTH + data.size(), 0x00);
 
     ucdrBuffer ub;
     ucdr_init_buffer(&ub, &buffer.front(), uint32_t(buffer.capacity()));
@@ -202,7 +209,7 @@ std::vector<uint8_t> ClientSerialization::write_data_payload_data()
     payload.base.object_id = ObjectId{0x45, 0x67};
 
     uxr_serialize_WRITE_DATA_Payload_Data(&ub, &payload);
-    ucdr_serialize_array_char(&ub, "BYTES", 5);
+    ucdr_serialize_array_uint8_t(&ub, data.data(), uint32_t(data.size()));
 
     buffer.resize(std::size_t(ub.iterator - ub.init));
 
@@ -211,31 +218,32 @@ std::vector<uint8_t> ClientSerialization::write_data_payload_data()
 
 std::vector<uint8_t> ClientSerialization::write_data_payload_sample()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::SAMPLE));
 }
 
 std::vector<uint8_t> ClientSerialization::write_data_payload_data_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::DATA_SEQ));
 }
 
 std::vector<uint8_t> ClientSerialization::write_data_payload_sample_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::SAMPLE_SEQ));
 }
 
 std::vector<uint8_t> ClientSerialization::write_data_payload_packed_samples()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return write_data_payload(default_data_values(DataFormat::PACKED_SAMPLES));
 }
 
 std::vector<uint8_t> ClientSerialization::data_payload_data()
 {
-    std::vector<uint8_t> buffer(BUFFER_LENGTH, 0x00);
+    return data_payload_data({'B', 'Y', 'T', 'E', 'S'});
+}
+
+std::vector<uint8_t> ClientSerialization::data_payload_data(const std::vector<uint8_t>& data)
+{
+    std::vector<uint8_t> buffer(BUFFER_LENGTH + data.size(), 0x00);
 
     ucdrBuffer ub;
     ucdr_init_buffer(&ub, &buffer.front(), uint32_t(buffer.capacity()));
@@ -245,7 +253,7 @@ std::vector<uint8_t> ClientSerialization::data_payload_data()
     base.object_id = ObjectId{0x45, 0x67};
 
     uxr_serialize_BaseObjectRequest(&ub, &base);
-    ucdr_serialize_array_char(&ub, "BYTES", 5);
+    ucdr_serialize_array_uint8_t(&ub, data.data(), uint32_t(data.size()));
 
     buffer.resize(std::size_t(ub.iterator - ub.init));
 
@@ -254,26 +262,22 @@ std::vector<uint8_t> ClientSerialization::data_payload_data()
 
 std::vector<uint8_t> ClientSerialization::data_payload_sample()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::SAMPLE));
 }
 
 std::vector<uint8_t> ClientSerialization::data_payload_data_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::DATA_SEQ));
 }
 
 std::vector<uint8_t> ClientSerialization::data_payload_sample_seq()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::SAMPLE_SEQ));
 }
 
 std::vector<uint8_t> ClientSerialization::data_payload_packed_samples()
 {
-    //TODO
-    return std::vector<uint8_t>();
+    return data_payload(default_data_values(DataFormat::PACKED_SAMPLES));
 }
 
 std::vector<uint8_t> ClientSerialization::acknack_payload()
@@ -313,3 +317,364 @@ std::vector<uint8_t> ClientSerialization::heartbeat_payload()
     return buffer;
 }
 
+
+/*
+ * Payloads of the given values. The sequences and the sample data of the Client types are arrays,
+ * which the values never exceed.
+ */
+static_assert(sizeof(SampleData::data) >= max_sample_data, "Client sample data smaller than the values");
+static_assert(sizeof(SampleDataSeq::data) / sizeof(SampleData) >= max_sequence_length,
+              "Client data sequences shorter than the values");
+static_assert(sizeof(SampleSeq::data) / sizeof(Sample) >= max_sequence_length,
+              "Client sample sequences shorter than the values");
+static_assert(sizeof(SampleDeltaSequence::data) / sizeof(SampleDelta) >= max_sequence_length,
+              "Client packed samples shorter than the values");
+static_assert(sizeof(BinarySequence_t::data) >= max_binary_length, "Client binary representations shorter than the values");
+
+template<typename T>
+static void set_binary_representation(T& representation, const CreateValues& values)
+{
+    representation.format = REPRESENTATION_IN_BINARY;
+    representation._.binary_representation.size = uint32_t(values.representation.size());
+    std::copy(values.representation.begin(), values.representation.end(), representation._.binary_representation.data);
+}
+
+template<typename T>
+static void set_representation(T& representation, const CreateValues& values)
+{
+    switch(values.format)
+    {
+        case RepresentationFormat::BY_REFERENCE:
+            representation.format = REPRESENTATION_BY_REFERENCE;
+            representation._.object_reference = const_cast<char*>(values.representation.c_str());
+            break;
+        case RepresentationFormat::AS_XML_STRING:
+            representation.format = REPRESENTATION_AS_XML_STRING;
+            representation._.xml_string_represenatation = const_cast<char*>(values.representation.c_str());
+            break;
+        case RepresentationFormat::IN_BINARY:
+            set_binary_representation(representation, values);
+            break;
+    }
+}
+
+template<typename T>
+static void set_bin_and_xml_representation(T& representation, const CreateValues& values)
+{
+    if(RepresentationFormat::IN_BINARY == values.format)
+    {
+        set_binary_representation(representation, values);
+    }
+    else
+    {
+        representation.format = REPRESENTATION_AS_XML_STRING;
+        representation._.string_represenatation = const_cast<char*>(values.representation.c_str());
+    }
+}
+
+template<typename T>
+static void set_ref_and_xml_representation(T& representation, const CreateValues& values)
+{
+    if(RepresentationFormat::BY_REFERENCE == values.format)
+    {
+        representation.format = REPRESENTATION_BY_REFERENCE;
+        representation._.object_name = const_cast<char*>(values.representation.c_str());
+    }
+    else
+    {
+        representation.format = REPRESENTATION_AS_XML_STRING;
+        representation._.xml_string_represenatation = const_cast<char*>(values.representation.c_str());
+    }
+}
+
+static void set_base(BaseObjectRequest& base, const BaseRequestValues& values)
+{
+    base.request_id = RequestId{values.request_id[0], values.request_id[1]};
+    base.object_id = ObjectId{values.object_id[0], values.object_id[1]};
+}
+
+static void set_sample_info(SampleInfo& info, const SampleInfoValues& values)
+{
+    info.state = values.state;
+    info.sequence_number = values.sequence_number;
+    info.session_time_offset = values.session_time_offset;
+}
+
+static void set_sample_data(SampleData& sample, const std::vector<uint8_t>& data)
+{
+    sample.size = uint32_t(data.size());
+    std::copy(data.begin(), data.end(), sample.data);
+}
+
+static void set_sample(Sample& sample, const DataValues& values, size_t index)
+{
+    set_sample_info(sample.info, values.info[index]);
+    set_sample_data(sample.data, values.data[index]);
+}
+
+static void set_packed_samples(PackedSamples& packed, const DataValues& values)
+{
+    set_sample_info(packed.info, values.info[0]);
+    packed.sample_delta_seq.size = uint32_t(values.deltas.size());
+    for(size_t i = 0; i < values.deltas.size(); ++i)
+    {
+        SampleDelta& delta = packed.sample_delta_seq.data[i];
+        delta.info_delta.state = values.deltas[i].state;
+        delta.info_delta.seq_number_delta = values.deltas[i].seq_number_delta;
+        delta.info_delta.timestamp_delta = values.deltas[i].timestamp_delta;
+        set_sample_data(delta.data, values.deltas[i].data);
+    }
+}
+
+/*
+ * WRITE_DATA and DATA payloads of each format share their fields, hence their construction. The
+ * data of the DATA format follows the base of the request, as the Client writes it.
+ */
+template<typename SamplePayload, typename DataSeqPayload, typename SampleSeqPayload, typename PackedSamplesPayload>
+static std::vector<uint8_t> serialize_data_payload(
+        const DataValues& values,
+        bool (*serialize_sample)(ucdrBuffer*, const SamplePayload*),
+        bool (*serialize_data_seq)(ucdrBuffer*, const DataSeqPayload*),
+        bool (*serialize_sample_seq)(ucdrBuffer*, const SampleSeqPayload*),
+        bool (*serialize_packed_samples)(ucdrBuffer*, const PackedSamplesPayload*))
+{
+    size_t data_length = 0;
+    for(const auto& data : values.data)
+    {
+        data_length += data.size();
+    }
+    for(const auto& delta : values.deltas)
+    {
+        data_length += delta.data.size();
+    }
+    std::vector<uint8_t> buffer(BUFFER_LENGTH + data_length, 0x00);
+
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, &buffer.front(), uint32_t(buffer.capacity()));
+
+    switch(values.format)
+    {
+        case DataFormat::DATA:
+        {
+            BaseObjectRequest base;
+            set_base(base, values.base);
+            uxr_serialize_BaseObjectRequest(&ub, &base);
+            ucdr_serialize_array_uint8_t(&ub, values.data[0].data(), uint32_t(values.data[0].size()));
+            break;
+        }
+        case DataFormat::SAMPLE:
+        {
+            std::unique_ptr<SamplePayload> payload(new SamplePayload());
+            set_base(payload->base, values.base);
+            set_sample(payload->sample, values, 0);
+            serialize_sample(&ub, payload.get());
+            break;
+        }
+        case DataFormat::DATA_SEQ:
+        {
+            std::unique_ptr<DataSeqPayload> payload(new DataSeqPayload());
+            set_base(payload->base, values.base);
+            payload->data_seq.size = uint32_t(values.data.size());
+            for(size_t i = 0; i < values.data.size(); ++i)
+            {
+                set_sample_data(payload->data_seq.data[i], values.data[i]);
+            }
+            serialize_data_seq(&ub, payload.get());
+            break;
+        }
+        case DataFormat::SAMPLE_SEQ:
+        {
+            std::unique_ptr<SampleSeqPayload> payload(new SampleSeqPayload());
+            set_base(payload->base, values.base);
+            payload->sample_seq.size = uint32_t(values.data.size());
+            for(size_t i = 0; i < values.data.size(); ++i)
+            {
+                set_sample(payload->sample_seq.data[i], values, i);
+            }
+            serialize_sample_seq(&ub, payload.get());
+            break;
+        }
+        case DataFormat::PACKED_SAMPLES:
+        {
+            std::unique_ptr<PackedSamplesPayload> payload(new PackedSamplesPayload());
+            set_base(payload->base, values.base);
+            set_packed_samples(payload->packed_samples, values);
+            serialize_packed_samples(&ub, payload.get());
+            break;
+        }
+    }
+
+    buffer.resize(std::size_t(ub.iterator - ub.init));
+
+    return buffer;
+}
+
+std::vector<uint8_t> ClientSerialization::create_payload(const CreateValues& values)
+{
+    std::vector<uint8_t> buffer(BUFFER_LENGTH + values.representation.size() + values.type_name.size(), 0x00);
+
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, &buffer.front(), uint32_t(buffer.capacity()));
+
+    CREATE_Payload payload;
+    payload.base.request_id = RequestId{values.base.request_id[0], values.base.request_id[1]};
+    payload.base.object_id = ObjectId{values.base.object_id[0], values.base.object_id[1]};
+    ObjectId parent_id = ObjectId{values.parent_id[0], values.parent_id[1]};
+    switch(values.kind)
+    {
+        case ObjectKind::PARTICIPANT:
+            payload.object_representation.kind = OBJK_PARTICIPANT;
+            set_representation(payload.object_representation._.participant.base.representation, values);
+            payload.object_representation._.participant.domain_id = values.domain_id;
+            break;
+        case ObjectKind::TOPIC:
+            payload.object_representation.kind = OBJK_TOPIC;
+            set_representation(payload.object_representation._.topic.base.representation, values);
+            payload.object_representation._.topic.participant_id = parent_id;
+            break;
+        case ObjectKind::PUBLISHER:
+            payload.object_representation.kind = OBJK_PUBLISHER;
+            set_bin_and_xml_representation(payload.object_representation._.publisher.base.representation, values);
+            payload.object_representation._.publisher.participant_id = parent_id;
+            break;
+        case ObjectKind::SUBSCRIBER:
+            payload.object_representation.kind = OBJK_SUBSCRIBER;
+            set_bin_and_xml_representation(payload.object_representation._.subscriber.base.representation, values);
+            payload.object_representation._.subscriber.participant_id = parent_id;
+            break;
+        case ObjectKind::DATAWRITER:
+            payload.object_representation.kind = OBJK_DATAWRITER;
+            set_representation(payload.object_representation._.data_writer.base.representation, values);
+            payload.object_representation._.data_writer.publisher_id = parent_id;
+            break;
+        case ObjectKind::DATAREADER:
+            payload.object_representation.kind = OBJK_DATAREADER;
+            set_representation(payload.object_representation._.data_reader.base.representation, values);
+            payload.object_representation._.data_reader.subscriber_id = parent_id;
+            break;
+        case ObjectKind::TYPE:
+            payload.object_representation.kind = OBJK_TYPE;
+            set_representation(payload.object_representation._.type.base.representation, values);
+            payload.object_representation._.type.participant_id = parent_id;
+            payload.object_representation._.type.registered_type_name = const_cast<char*>(values.type_name.c_str());
+            break;
+        case ObjectKind::QOSPROFILE:
+            payload.object_representation.kind = OBJK_QOSPROFILE;
+            set_ref_and_xml_representation(payload.object_representation._.qos_profile.base.representation, values);
+            break;
+        case ObjectKind::APPLICATION:
+            payload.object_representation.kind = OBJK_APPLICATION;
+            set_ref_and_xml_representation(payload.object_representation._.application.base.representation, values);
+            break;
+        case ObjectKind::AGENT:
+            payload.object_representation.kind = OBJK_AGENT;
+            payload.object_representation._.agent.xrce_cookie = XrceCookie{values.xrce_cookie[0], values.xrce_cookie[1],
+                                                                           values.xrce_cookie[2], values.xrce_cookie[3]};
+            payload.object_representation._.agent.xrce_version = XrceVersion{values.xrce_version[0], values.xrce_version[1]};
+            payload.object_representation._.agent.xrce_vendor_id = XrceVendorId{values.xrce_vendor_id[0],
+                                                                                values.xrce_vendor_id[1]};
+            payload.object_representation._.agent.optional_properties = 0x00;
+            break;
+        case ObjectKind::CLIENT:
+            payload.object_representation.kind = OBJK_CLIENT;
+            payload.object_representation._.client.xrce_cookie = XrceCookie{values.xrce_cookie[0], values.xrce_cookie[1],
+                                                                            values.xrce_cookie[2], values.xrce_cookie[3]};
+            payload.object_representation._.client.xrce_version = XrceVersion{values.xrce_version[0], values.xrce_version[1]};
+            payload.object_representation._.client.xrce_vendor_id = XrceVendorId{values.xrce_vendor_id[0],
+                                                                                 values.xrce_vendor_id[1]};
+            payload.object_representation._.client.client_key = ClientKey{values.client_key[0], values.client_key[1],
+                                                                          values.client_key[2], values.client_key[3]};
+            payload.object_representation._.client.session_id = values.session_id;
+            payload.object_representation._.client.optional_properties = 0x00;
+            payload.object_representation._.client.mtu = values.mtu;
+            break;
+    }
+
+    uxr_serialize_CREATE_Payload(&ub, &payload);
+
+    buffer.resize(std::size_t(ub.iterator - ub.init));
+
+    return buffer;
+}
+
+std::vector<uint8_t> ClientSerialization::read_data_payload(const ReadDataValues& values)
+{
+    std::vector<uint8_t> buffer(BUFFER_LENGTH + values.filter.size(), 0x00);
+
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, &buffer.front(), uint32_t(buffer.capacity()));
+
+    READ_DATA_Payload payload;
+    payload.base.request_id = RequestId{values.base.request_id[0], values.base.request_id[1]};
+    payload.base.object_id = ObjectId{values.base.object_id[0], values.base.object_id[1]};
+    payload.read_specification.preferred_stream_id = values.preferred_stream_id;
+    payload.read_specification.data_format = values.data_format;
+    payload.read_specification.optional_content_filter_expression = values.has_filter;
+    payload.read_specification.content_filter_expression = const_cast<char*>(values.filter.c_str());
+    payload.read_specification.optional_delivery_control = values.has_delivery_control;
+    payload.read_specification.delivery_control.max_samples = values.max_samples;
+    payload.read_specification.delivery_control.max_elapsed_time = values.max_elapsed_time;
+    payload.read_specification.delivery_control.max_bytes_per_seconds = values.max_bytes_per_second;
+    payload.read_specification.delivery_control.min_pace_period = values.min_pace_period;
+
+    uxr_serialize_READ_DATA_Payload(&ub, &payload);
+
+    buffer.resize(std::size_t(ub.iterator - ub.init));
+
+    return buffer;
+}
+
+std::vector<uint8_t> ClientSerialization::write_data_payload(const DataValues& values)
+{
+    return serialize_data_payload(values,
+                                  &uxr_serialize_WRITE_DATA_Payload_Sample,
+                                  &uxr_serialize_WRITE_DATA_Payload_DataSeq,
+                                  &uxr_serialize_WRITE_DATA_Payload_SampleSeq,
+                                  &uxr_serialize_WRITE_DATA_Payload_PackedSamples);
+}
+
+std::vector<uint8_t> ClientSerialization::data_payload(const DataValues& values)
+{
+    return serialize_data_payload(values,
+                                  &uxr_serialize_DATA_Payload_Sample,
+                                  &uxr_serialize_DATA_Payload_DataSeq,
+                                  &uxr_serialize_DATA_Payload_SampleSeq,
+                                  &uxr_serialize_DATA_Payload_PackedSamples);
+}
+
+std::vector<uint8_t> ClientSerialization::acknack_payload(const AcknackValues& values)
+{
+    std::vector<uint8_t> buffer(BUFFER_LENGTH, 0x00);
+
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, &buffer.front(), uint32_t(buffer.capacity()));
+
+    ACKNACK_Payload payload;
+    payload.first_unacked_seq_num = values.first_unacked_seq_num;
+    payload.nack_bitmap[0] = values.nack_bitmap[0];
+    payload.nack_bitmap[1] = values.nack_bitmap[1];
+    payload.stream_id = values.stream_id;
+    uxr_serialize_ACKNACK_Payload(&ub, &payload);
+
+    buffer.resize(std::size_t(ub.iterator - ub.init));
+
+    return buffer;
+}
+
+std::vector<uint8_t> ClientSerialization::heartbeat_payload(const HeartbeatValues& values)
+{
+    std::vector<uint8_t> buffer(BUFFER_LENGTH, 0x00);
+
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, &buffer.front(), uint32_t(buffer.capacity()));
+
+    HEARTBEAT_Payload payload;
+    payload.first_unacked_seq_nr = values.first_unacked_seq_nr;
+    payload.last_unacked_seq_nr = values.last_unacked_seq_nr;
+    payload.stream_id = values.stream_id;
+    uxr_serialize_HEARTBEAT_Payload(&ub, &payload);
+
+    buffer.resize(std::size_t(ub.iterator - ub.init));
+
+    return buffer;
+}
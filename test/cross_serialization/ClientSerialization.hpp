@@ -1,6 +1,8 @@
 #ifndef IN_TEST_CLIENT_CROSS_SERIALIZATION_HPP
 #define IN_TEST_CLIENT_CROSS_SERIALIZATION_HPP
 
+#include "SerializationValues.hpp"
+
 #include <cstdint>
 #include <vector>
 
@@ -15,17 +17,26 @@ struct ClientSerialization
     static std::vector<uint8_t> info_payload();
     static std::vector<uint8_t> read_data_payload();
     static std::vector<uint8_t> write_data_payload_data();
+    static std::vector<uint8_t> write_data_payload_data(const std::vector<uint8_t>& data);
     static std::vector<uint8_t> write_data_payload_sample();
     static std::vector<uint8_t> write_data_payload_data_seq();
     static std::vector<uint8_t> write_data_payload_sample_seq();
     static std::vector<uint8_t> write_data_payload_packed_samples();
     static std::vector<uint8_t> data_payload_data();
+    static std::vector<uint8_t> data_payload_data(const std::vector<uint8_t>& data);
     static std::vector<uint8_t> data_payload_sample();
     static std::vector<uint8_t> data_payload_data_seq();
     static std::vector<uint8_t> data_payload_sample_seq();
     static std::vector<uint8_t> data_payload_packed_samples();
     static std::vector<uint8_t> acknack_payload();
     static std::vector<uint8_t> heartbeat_payload();
+
+    static std::vector<uint8_t> create_payload(const CreateValues& values);
+    static std::vector<uint8_t> read_data_payload(const ReadDataValues& values);
+    static std::vector<uint8_t> write_data_payload(const DataValues& values);
+    static std::vector<uint8_t> data_payload(const DataValues& values);
+    static std::vector<uint8_t> acknack_payload(const AcknackValues& values);
+    static std::vector<uint8_t> heartbeat_payload(const HeartbeatValues& values);
 };
 
 #endif //IN_TEST_CLIENT_CROSS_SERIALIZATION_HPP
@@ -88,12 +88,60 @@ TEST_F(CrossSerializationTests, WriteDataPayloadData)
     agent_ser = AgentSerialization::write_data_payload_data();
 }
 
+TEST_F(CrossSerializationTests, WriteDataPayloadSample)
+{
+    client_ser = ClientSerialization::write_data_payload_sample();
+    agent_ser = AgentSerialization::write_data_payload_sample();
+}
+
+TEST_F(CrossSerializationTests, WriteDataPayloadDataSeq)
+{
+    client_ser = ClientSerialization::write_data_payload_data_seq();
+    agent_ser = AgentSerialization::write_data_payload_data_seq();
+}
+
+TEST_F(CrossSerializationTests, WriteDataPayloadSampleSeq)
+{
+    client_ser = ClientSerialization::write_data_payload_sample_seq();
+    agent_ser = AgentSerialization::write_data_payload_sample_seq();
+}
+
+TEST_F(CrossSerializationTests, WriteDataPayloadPackedSamples)
+{
+    client_ser = ClientSerialization::write_data_payload_packed_samples();
+    agent_ser = AgentSerialization::write_data_payload_packed_samples();
+}
+
 TEST_F(CrossSerializationTests, DataPayloadData)
 {
     client_ser = ClientSerialization::data_payload_data();
     agent_ser = AgentSerialization::data_payload_data();
 }
 
+TEST_F(CrossSerializationTests, DataPayloadSample)
+{
+    client_ser = ClientSerialization::data_payload_sample();
+    agent_ser = AgentSerialization::data_payload_sample();
+}
+
+TEST_F(CrossSerializationTests, DataPayloadDataSeq)
+{
+    client_ser = ClientSerialization::data_payload_data_seq();
+    agent_ser = AgentSerialization::data_payload_data_seq();
+}
+
+TEST_F(CrossSerializationTests, DataPayloadSampleSeq)
+{
+    client_ser = ClientSerialization::data_payload_sample_seq();
+    agent_ser = AgentSerialization::data_payload_sample_seq();
+}
+
+TEST_F(CrossSerializationTests, DataPayloadPackedSamples)
+{
+    client_ser = ClientSerialization::data_payload_packed_samples();
+    agent_ser = AgentSerialization::data_payload_packed_samples();
+}
+
 TEST_F(CrossSerializationTests, AcknackPayload)
 {
     client_ser = ClientSerialization::acknack_payload();
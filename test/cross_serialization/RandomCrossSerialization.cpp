@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "ClientSerialization.hpp"
+#include "AgentSerialization.hpp"
+
+#include <uxr/client/config.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+
+#define AGENT_HEADER_OFFSET 12 //Used for skip the agent header and subheader
+#define RANDOM_PAYLOADS 2000
+#define RANDOM_SEED 0x00C0FFEE
+#define RANDOM_MAX_DATA (UXR_CONFIG_UDP_TRANSPORT_MTU - 512) //Room for the headers of the samples
+
+/*
+ * Every payload is built from random values by both sides, which must serialize the very same
+ * bytes. Payload n of a kind is generated from seed RANDOM_SEED + n, reported on a mismatch. The
+ * time each side spends serializing is reported as a property of the test.
+ */
+class RandomCrossSerializationTests : public testing::Test
+{
+protected:
+    typedef std::chrono::steady_clock Clock;
+
+    template<typename T>
+    void check(
+            const std::string& kind,
+            std::function<T(RandomValues&)> generate,
+            std::vector<uint8_t> (*client)(const T&),
+            std::vector<uint8_t> (*agent)(const T&))
+    {
+        std::chrono::nanoseconds client_time(0);
+        std::chrono::nanoseconds agent_time(0);
+        size_t bytes = 0;
+        for(uint32_t i = 0; i < RANDOM_PAYLOADS; ++i)
+        {
+            RandomValues random(RANDOM_SEED + i, RANDOM_MAX_DATA);
+            T values = generate(random);
+
+            Clock::time_point begin = Clock::now();
+            std::vector<uint8_t> client_ser = client(values);
+            Clock::time_point middle = Clock::now();
+            std::vector<uint8_t> agent_ser = agent(values);
+            Clock::time_point end = Clock::now();
+            client_time += middle - begin;
+            agent_time += end - middle;
+            bytes += client_ser.size();
+
+            ASSERT_LE(size_t(AGENT_HEADER_OFFSET), agent_ser.size()) << kind << " payload of seed " << RANDOM_SEED + i;
+            agent_ser.erase(agent_ser.begin(), agent_ser.begin() + AGENT_HEADER_OFFSET);
+            ASSERT_EQ(client_ser, agent_ser) << kind << " payload of seed " << RANDOM_SEED + i;
+        }
+
+        int client_ns = int(client_time.count() / RANDOM_PAYLOADS);
+        int agent_ns = int(agent_time.count() / RANDOM_PAYLOADS);
+        RecordProperty(kind + "_client_ns", client_ns);
+        RecordProperty(kind + "_agent_ns", agent_ns);
+        std::cout << kind << ": " << RANDOM_PAYLOADS << " payloads, " << bytes / RANDOM_PAYLOADS << " B on average, "
+                  << "client " << client_ns << " ns, agent " << agent_ns << " ns per payload" << std::endl;
+    }
+
+    void check_write_data(const std::string& kind, DataFormat format)
+    {
+        check<DataValues>(kind, data_generator(format),
+                &ClientSerialization::write_data_payload, &AgentSerialization::write_data_payload);
+    }
+
+    void check_data(const std::string& kind, DataFormat format)
+    {
+        check<DataValues>(kind, data_generator(format),
+                &ClientSerialization::data_payload, &AgentSerialization::data_payload);
+    }
+
+private:
+    static std::function<DataValues(RandomValues&)> data_generator(DataFormat format)
+    {
+        return [format](RandomValues& random)
+        {
+            return random.data(format);
+        };
+    }
+};
+
+/* ############################################## TESTS ##################################################### */
+
+TEST_F(RandomCrossSerializationTests, CreatePayload)
+{
+    check<CreateValues>("create", [](RandomValues& random) { return random.create(); },
+            &ClientSerialization::create_payload, &AgentSerialization::create_payload);
+}
+
+TEST_F(RandomCrossSerializationTests, ReadDataPayload)
+{
+    check<ReadDataValues>("read_data", [](RandomValues& random) { return random.read_data(); },
+            &ClientSerialization::read_data_payload, &AgentSerialization::read_data_payload);
+}
+
+TEST_F(RandomCrossSerializationTests, WriteDataPayload)
+{
+    check_write_data("write_data_data", DataFormat::DATA);
+    check_write_data("write_data_sample", DataFormat::SAMPLE);
+    check_write_data("write_data_data_seq", DataFormat::DATA_SEQ);
+    check_write_data("write_data_sample_seq", DataFormat::SAMPLE_SEQ);
+    check_write_data("write_data_packed_samples", DataFormat::PACKED_SAMPLES);
+}
+
+TEST_F(RandomCrossSerializationTests, DataPayload)
+{
+    check_data("data_data", DataFormat::DATA);
+    check_data("data_sample", DataFormat::SAMPLE);
+    check_data("data_data_seq", DataFormat::DATA_SEQ);
+    check_data("data_sample_seq", DataFormat::SAMPLE_SEQ);
+    check_data("data_packed_samples", DataFormat::PACKED_SAMPLES);
+}
+
+TEST_F(RandomCrossSerializationTests, AcknackPayload)
+{
+    check<AcknackValues>("acknack", [](RandomValues& random) { return random.acknack(); },
+            &ClientSerialization::acknack_payload, &AgentSerialization::acknack_payload);
+}
+
+TEST_F(RandomCrossSerializationTests, HeartbeatPayload)
+{
+    check<HeartbeatValues>("heartbeat", [](RandomValues& random) { return random.heartbeat(); },
+            &ClientSerialization::heartbeat_payload, &AgentSerialization::heartbeat_payload);
+}
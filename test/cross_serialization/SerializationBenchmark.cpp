@@ -0,0 +1,161 @@
+#include "ClientSerialization.hpp"
+#include "AgentSerialization.hpp"
+
+#include <core/serialization/xrce_header_internal.h>
+#include <core/serialization/xrce_subheader_internal.h>
+#include <ucdr/microcdr.h>
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+/*
+ * Every allocation of the process is counted, so that the allocations per message of each
+ * builder, std::vector included, are reported along with its time.
+ */
+static std::atomic<uint64_t> allocation_count(0);
+
+#define CLIENT_HEADER_SIZE 12 //Header with the client key, and subheader
+
+void* operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = std::malloc((0 != size) ? size : 1);
+    if(nullptr == ptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+typedef std::vector<uint8_t> (*Builder)();
+typedef std::vector<uint8_t> (*DataBuilder)(const std::vector<uint8_t>& data);
+
+/*
+ * Message of a Client payload, with the header and the subheader the Agent builders write, so
+ * that both sides are benchmarked on the same scope. The payload is copied once into the message,
+ * as the Agent builders copy theirs out of the OutputMessage.
+ */
+static std::vector<uint8_t> client_message(uint8_t submessage_id, const std::vector<uint8_t>& payload)
+{
+    const uint8_t client_key[4] = {0xF1, 0xF2, 0xF3, 0xF4};
+    std::vector<uint8_t> message(CLIENT_HEADER_SIZE + payload.size());
+
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, &message.front(), uint32_t(message.size()));
+    uxr_serialize_message_header(&ub, 0x01, 0x04, 0x0001, client_key);
+    uxr_serialize_submessage_header(&ub, submessage_id, 0x01, uint16_t(payload.size()));
+    std::copy(payload.begin(), payload.end(), message.begin() + CLIENT_HEADER_SIZE);
+
+    return message;
+}
+
+template<uint8_t ID, Builder B>
+static std::vector<uint8_t> client_message()
+{
+    return client_message(ID, B());
+}
+
+template<uint8_t ID, DataBuilder B>
+static std::vector<uint8_t> client_data_message(const std::vector<uint8_t>& data)
+{
+    return client_message(ID, B(data));
+}
+
+static void report(benchmark::State& state, size_t message_size, uint64_t allocations)
+{
+    state.SetItemsProcessed(int64_t(state.iterations()));
+    state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(message_size));
+    state.counters["message_size"] = double(message_size);
+    state.counters["allocs_per_op"] = benchmark::Counter(double(allocations), benchmark::Counter::kAvgIterations);
+}
+
+/*
+ * Builds the whole message of a fixed payload kind, header and subheader included.
+ */
+static void BM_Payload(benchmark::State& state, Builder builder)
+{
+    size_t message_size = 0;
+    uint64_t allocations = allocation_count.load(std::memory_order_relaxed);
+    for(auto _ : state)
+    {
+        std::vector<uint8_t> message = builder();
+        benchmark::DoNotOptimize(message.data());
+        message_size = message.size();
+    }
+    report(state, message_size, allocation_count.load(std::memory_order_relaxed) - allocations);
+}
+
+/*
+ * Builds the message of a data payload kind, carrying state.range(0) bytes of data.
+ */
+static void BM_DataPayload(benchmark::State& state, DataBuilder builder)
+{
+    std::vector<uint8_t> data(size_t(state.range(0)), 0xA5);
+    size_t message_size = 0;
+    uint64_t allocations = allocation_count.load(std::memory_order_relaxed);
+    for(auto _ : state)
+    {
+        std::vector<uint8_t> message = builder(data);
+        benchmark::DoNotOptimize(message.data());
+        message_size = message.size();
+    }
+    report(state, message_size, allocation_count.load(std::memory_order_relaxed) - allocations);
+}
+
+/*
+ * Data lengths stay below the 64 KiB a submessage may hold.
+ */
+static void data_lengths(benchmark::internal::Benchmark* benchmark)
+{
+    benchmark->RangeMultiplier(4)->Range(8, 32768);
+}
+
+BENCHMARK_CAPTURE(BM_Payload, Client/CreateClient,
+        &client_message<SUBMESSAGE_ID_CREATE_CLIENT, &ClientSerialization::create_client_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/CreateClient, &AgentSerialization::create_client_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/Create,
+        &client_message<SUBMESSAGE_ID_CREATE, &ClientSerialization::create_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/Create, &AgentSerialization::create_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/GetInfo,
+        &client_message<SUBMESSAGE_ID_GET_INFO, &ClientSerialization::get_info_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/GetInfo, &AgentSerialization::get_info_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/Delete,
+        &client_message<SUBMESSAGE_ID_DELETE, &ClientSerialization::delete_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/Delete, &AgentSerialization::delete_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/StatusAgent,
+        &client_message<SUBMESSAGE_ID_STATUS_AGENT, &ClientSerialization::status_agent_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/StatusAgent, &AgentSerialization::status_agent_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/Status,
+        &client_message<SUBMESSAGE_ID_STATUS, &ClientSerialization::status_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/Status, &AgentSerialization::status_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/Info,
+        &client_message<SUBMESSAGE_ID_INFO, &ClientSerialization::info_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/Info, &AgentSerialization::info_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/ReadData,
+        &client_message<SUBMESSAGE_ID_READ_DATA, &ClientSerialization::read_data_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/ReadData, &AgentSerialization::read_data_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/Acknack,
+        &client_message<SUBMESSAGE_ID_ACKNACK, &ClientSerialization::acknack_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/Acknack, &AgentSerialization::acknack_payload);
+BENCHMARK_CAPTURE(BM_Payload, Client/Heartbeat,
+        &client_message<SUBMESSAGE_ID_HEARTBEAT, &ClientSerialization::heartbeat_payload>);
+BENCHMARK_CAPTURE(BM_Payload, Agent/Heartbeat, &AgentSerialization::heartbeat_payload);
+
+BENCHMARK_CAPTURE(BM_DataPayload, Client/WriteData,
+        &client_data_message<SUBMESSAGE_ID_WRITE_DATA, &ClientSerialization::write_data_payload_data>)->Apply(data_lengths);
+BENCHMARK_CAPTURE(BM_DataPayload, Agent/WriteData, &AgentSerialization::write_data_payload_data)->Apply(data_lengths);
+BENCHMARK_CAPTURE(BM_DataPayload, Client/Data,
+        &client_data_message<SUBMESSAGE_ID_DATA, &ClientSerialization::data_payload_data>)->Apply(data_lengths);
+BENCHMARK_CAPTURE(BM_DataPayload, Agent/Data, &AgentSerialization::data_payload_data)->Apply(data_lengths);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,383 @@
+#ifndef IN_TEST_CROSS_SERIALIZATION_VALUES_HPP
+#define IN_TEST_CROSS_SERIALIZATION_VALUES_HPP
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+/*
+ * Capacity of the sequences and of the sample data of the Client types, which are arrays.
+ */
+constexpr size_t max_sequence_length = 8;
+constexpr size_t max_sample_data = 512;
+constexpr size_t max_binary_length = 8;
+
+/*
+ * Plain values of the payloads, given to the builders of both sides, so that the same payload is
+ * serialized by the Client and the Agent whatever the values.
+ */
+enum class ObjectKind : uint8_t
+{
+    PARTICIPANT = 0x01,
+    TOPIC = 0x02,
+    PUBLISHER = 0x03,
+    SUBSCRIBER = 0x04,
+    DATAWRITER = 0x05,
+    DATAREADER = 0x06,
+    TYPE = 0x0A,
+    QOSPROFILE = 0x0B,
+    APPLICATION = 0x0C,
+    AGENT = 0x0D,
+    CLIENT = 0x0E
+};
+
+enum class RepresentationFormat : uint8_t
+{
+    BY_REFERENCE = 0x01,
+    AS_XML_STRING = 0x02,
+    IN_BINARY = 0x03
+};
+
+enum class DataFormat : uint8_t
+{
+    DATA = 0x00,
+    SAMPLE = 0x02,
+    DATA_SEQ = 0x08,
+    SAMPLE_SEQ = 0x0A,
+    PACKED_SAMPLES = 0x0E
+};
+
+struct BaseRequestValues
+{
+    std::array<uint8_t, 2> request_id;
+    std::array<uint8_t, 2> object_id;
+};
+
+/*
+ * Objects are created by reference, from XML or in binary, as far as their kind allows: publishers
+ * and subscribers have no reference, applications and QoS profiles no binary representation. The
+ * bytes of a binary representation are held in representation. The parent is the participant,
+ * publisher or subscriber of the object, if any. Agents and clients are represented by their
+ * identification alone.
+ */
+struct CreateValues
+{
+    BaseRequestValues base;
+    ObjectKind kind;
+    RepresentationFormat format;
+    std::string representation;
+    int16_t domain_id;
+    std::array<uint8_t, 2> parent_id;
+    std::string type_name;
+    std::array<uint8_t, 4> xrce_cookie;
+    std::array<uint8_t, 2> xrce_version;
+    std::array<uint8_t, 2> xrce_vendor_id;
+    std::array<uint8_t, 4> client_key;
+    uint8_t session_id;
+    uint16_t mtu;
+};
+
+struct ReadDataValues
+{
+    BaseRequestValues base;
+    uint8_t preferred_stream_id;
+    uint8_t data_format;
+    bool has_filter;
+    std::string filter;
+    bool has_delivery_control;
+    uint16_t max_samples;
+    uint16_t max_elapsed_time;
+    uint16_t max_bytes_per_second;
+    uint16_t min_pace_period;
+};
+
+struct SampleInfoValues
+{
+    uint8_t state;
+    uint32_t sequence_number;
+    uint32_t session_time_offset;
+};
+
+struct SampleDeltaValues
+{
+    uint8_t state;
+    uint8_t seq_number_delta;
+    uint16_t timestamp_delta;
+    std::vector<uint8_t> data;
+};
+
+/*
+ * Samples of a WRITE_DATA or DATA payload, laid out according to its format: a single data or
+ * sample uses the first element of data and info, packed samples the first info and the deltas.
+ */
+struct DataValues
+{
+    BaseRequestValues base;
+    DataFormat format;
+    std::vector<SampleInfoValues> info;
+    std::vector<std::vector<uint8_t>> data;
+    std::vector<SampleDeltaValues> deltas;
+};
+
+struct AcknackValues
+{
+    uint16_t first_unacked_seq_num;
+    std::array<uint8_t, 2> nack_bitmap;
+    uint8_t stream_id;
+};
+
+struct HeartbeatValues
+{
+    uint16_t first_unacked_seq_nr;
+    uint16_t last_unacked_seq_nr;
+    uint8_t stream_id;
+};
+
+/*
+ * Values of the fixed data payloads: two samples of "BYTES" in the sequences and packed samples.
+ */
+inline DataValues default_data_values(DataFormat format)
+{
+    const std::vector<uint8_t> bytes = {'B', 'Y', 'T', 'E', 'S'};
+    const SampleInfoValues info = {0x89, 0x01234567, 0x89ABCDEF};
+
+    DataValues values;
+    values.base.request_id = {{0x01, 0x23}};
+    values.base.object_id = {{0x45, 0x67}};
+    values.format = format;
+    size_t count = ((DataFormat::DATA == format) || (DataFormat::SAMPLE == format)) ? 1 : 2;
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(DataFormat::PACKED_SAMPLES == format)
+        {
+            values.deltas.push_back(SampleDeltaValues{0x01, uint8_t(i + 1), 0x0123, bytes});
+        }
+        else
+        {
+            values.data.push_back(bytes);
+            values.info.push_back(info);
+        }
+    }
+    if(DataFormat::PACKED_SAMPLES == format)
+    {
+        values.info.push_back(info);
+    }
+    return values;
+}
+
+/*
+ * Generator of random payload values. Strings are printable, and the serialized data of a payload
+ * never exceeds max_data bytes in total, so that a payload fits in a message of that MTU.
+ */
+class RandomValues
+{
+public:
+    RandomValues(uint32_t seed, size_t max_data)
+    : random_(seed)
+    , max_data_(max_data)
+    {
+    }
+
+    /*
+     * Objects of every kind, in every representation format of their kind.
+     */
+    CreateValues create()
+    {
+        static const ObjectKind kinds[] = {ObjectKind::PARTICIPANT, ObjectKind::TOPIC, ObjectKind::PUBLISHER,
+                                           ObjectKind::SUBSCRIBER, ObjectKind::DATAWRITER, ObjectKind::DATAREADER,
+                                           ObjectKind::TYPE, ObjectKind::QOSPROFILE, ObjectKind::APPLICATION,
+                                           ObjectKind::AGENT, ObjectKind::CLIENT};
+        CreateValues values;
+        values.base = base();
+        values.kind = kinds[uniform(0, 10)];
+        values.format = format(values.kind);
+        if(RepresentationFormat::IN_BINARY == values.format)
+        {
+            std::vector<uint8_t> binary = bytes(uniform(0, max_binary_length));
+            values.representation.assign(binary.begin(), binary.end());
+        }
+        else
+        {
+            values.representation = text(uniform(0, max_data_ / 2));
+        }
+        values.domain_id = int16_t(uniform(0, 0x7FFF));
+        values.parent_id = pair();
+        values.type_name = text(uniform(0, max_data_ / 4));
+        values.xrce_cookie = quad();
+        values.xrce_version = pair();
+        values.xrce_vendor_id = pair();
+        values.client_key = quad();
+        values.session_id = octet();
+        values.mtu = uint16_t(uniform(0, 0xFFFF));
+        return values;
+    }
+
+    ReadDataValues read_data()
+    {
+        ReadDataValues values;
+        values.base = base();
+        values.preferred_stream_id = octet();
+        values.data_format = octet();
+        values.has_filter = (0 == uniform(0, 1));
+        values.filter = values.has_filter ? text(uniform(0, max_data_ / 2)) : std::string();
+        values.has_delivery_control = (0 == uniform(0, 1));
+        values.max_samples = uint16_t(uniform(0, 0xFFFF));
+        values.max_elapsed_time = uint16_t(uniform(0, 0xFFFF));
+        values.max_bytes_per_second = uint16_t(uniform(0, 0xFFFF));
+        values.min_pace_period = uint16_t(uniform(0, 0xFFFF));
+        return values;
+    }
+
+    /*
+     * Sequences hold from none to max_sequence_length samples, each one of random length. Samples
+     * hold up to max_sample_data bytes, the data of the DATA format up to max_data.
+     */
+    DataValues data(DataFormat format)
+    {
+        DataValues values;
+        values.base = base();
+        values.format = format;
+
+        size_t budget = max_data_;
+        size_t count = ((DataFormat::DATA == format) || (DataFormat::SAMPLE == format))
+                ? 1 : uniform(0, max_sequence_length);
+        for(size_t i = 0; i < count; ++i)
+        {
+            size_t max_length = budget / (count - i);
+            if(DataFormat::DATA != format)
+            {
+                max_length = std::min(max_length, max_sample_data);
+            }
+            size_t length = uniform(0, max_length);
+            budget -= length;
+            if(DataFormat::PACKED_SAMPLES == format)
+            {
+                SampleDeltaValues delta;
+                delta.state = octet();
+                delta.seq_number_delta = octet();
+                delta.timestamp_delta = uint16_t(uniform(0, 0xFFFF));
+                delta.data = bytes(length);
+                values.deltas.push_back(delta);
+            }
+            else
+            {
+                values.data.push_back(bytes(length));
+                values.info.push_back(sample_info());
+            }
+        }
+        if(DataFormat::PACKED_SAMPLES == format)
+        {
+            values.info.push_back(sample_info());
+        }
+        return values;
+    }
+
+    AcknackValues acknack()
+    {
+        AcknackValues values;
+        values.first_unacked_seq_num = uint16_t(uniform(0, 0xFFFF));
+        values.nack_bitmap = pair();
+        values.stream_id = octet();
+        return values;
+    }
+
+    HeartbeatValues heartbeat()
+    {
+        HeartbeatValues values;
+        values.first_unacked_seq_nr = uint16_t(uniform(0, 0xFFFF));
+        values.last_unacked_seq_nr = uint16_t(uniform(0, 0xFFFF));
+        values.stream_id = octet();
+        return values;
+    }
+
+private:
+    /*
+     * Values are taken straight from the output of the engine, which the standard fixes, unlike
+     * the distributions: a seed gives the same payload with any standard library.
+     */
+    size_t uniform(size_t min, size_t max)
+    {
+        return min + size_t(uint32_t(random_()) % (uint64_t(max - min) + 1));
+    }
+
+    uint8_t octet()
+    {
+        return uint8_t(uniform(0, 0xFF));
+    }
+
+    std::array<uint8_t, 2> pair()
+    {
+        return std::array<uint8_t, 2>{{octet(), octet()}};
+    }
+
+    std::array<uint8_t, 4> quad()
+    {
+        return std::array<uint8_t, 4>{{octet(), octet(), octet(), octet()}};
+    }
+
+    RepresentationFormat format(ObjectKind kind)
+    {
+        static const RepresentationFormat formats[] = {RepresentationFormat::BY_REFERENCE,
+                                                       RepresentationFormat::AS_XML_STRING,
+                                                       RepresentationFormat::IN_BINARY};
+        switch(kind)
+        {
+            case ObjectKind::PUBLISHER:
+            case ObjectKind::SUBSCRIBER:
+                return formats[uniform(1, 2)];
+            case ObjectKind::QOSPROFILE:
+            case ObjectKind::APPLICATION:
+                return formats[uniform(0, 1)];
+            default:
+                return formats[uniform(0, 2)];
+        }
+    }
+
+    BaseRequestValues base()
+    {
+        BaseRequestValues values;
+        values.request_id = pair();
+        values.object_id = pair();
+        return values;
+    }
+
+    SampleInfoValues sample_info()
+    {
+        SampleInfoValues values;
+        values.state = octet();
+        values.sequence_number = uint32_t(random_());
+        values.session_time_offset = uint32_t(random_());
+        return values;
+    }
+
+    std::string text(size_t length)
+    {
+        std::string value(length, ' ');
+        for(auto& c : value)
+        {
+            c = char(0x20 + random_() % 0x5F);
+        }
+        return value;
+    }
+
+    std::vector<uint8_t> bytes(size_t length)
+    {
+        std::vector<uint8_t> value(length);
+        uint32_t word = 0;
+        for(size_t i = 0; i < length; ++i)
+        {
+            word = (0 == i % 4) ? uint32_t(random_()) : word >> 8;
+            value[i] = uint8_t(word);
+        }
+        return value;
+    }
+
+    std::mt19937 random_;
+    size_t max_data_;
+};
+
+#endif //IN_TEST_CROSS_SERIALIZATION_VALUES_HPP
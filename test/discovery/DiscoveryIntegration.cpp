@@ -1,6 +1,7 @@
 #include <gtest/gtest.h>
 
 #include <Discovery.hpp>
+#include <TestIsolation.hpp>
 #ifdef _WIN32
 #include <uxr/agent/transport/udp/UDPServerWindows.hpp>
 #include <uxr/agent/transport/tcp/TCPServerWindows.hpp>
@@ -14,7 +15,6 @@
 class DiscoveryIntegration : public ::testing::TestWithParam<TransportKind>
 {
 public:
-    const uint16_t AGENT_PORT = 2018;
     const uint16_t DISCOVERY_PORT = eprosima::uxr::DISCOVERY_PORT;
 
     DiscoveryIntegration()
@@ -25,14 +25,18 @@ public:
     {
     }
 
-    std::vector<uint16_t> init_scenario(size_t number)
+    /*
+     * Agents listen on free ports, so that several tests run at once. Multicast discovery only
+     * reaches the agents on its well-known port.
+     */
+    std::vector<uint16_t> init_scenario(size_t number, bool multicast = false)
     {
         std::vector<uint16_t> agent_ports;
         std::vector<uint16_t> discovery_ports;
         for(size_t i = 0; i < number; i++)
         {
-            uint16_t agent_port = uint16_t(AGENT_PORT + i);
-            uint16_t discovery_port = uint16_t(DISCOVERY_PORT + i);
+            uint16_t agent_port = get_free_port(transport_);
+            uint16_t discovery_port = multicast ? DISCOVERY_PORT : get_free_port(TransportKind::udp);
             create_agent(agent_port, discovery_port);
             agent_ports.push_back(agent_port);
             discovery_ports.push_back(discovery_port);
@@ -82,7 +86,7 @@ TEST_P(DiscoveryIntegration, DiscoveryUnicast)
 
 TEST_P(DiscoveryIntegration, DiscoveryMulticast)
 {
-    init_scenario(1);
+    init_scenario(1, true);
     discovery_->multicast();
 }
 
@@ -0,0 +1,168 @@
+#include "Capture.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+const uint32_t PCAP_NANOSECOND_MAGIC = 0xa1b23c4d;
+const uint32_t PCAP_SNAPLEN = 65535;
+const uint32_t LINKTYPE_RAW = 101;
+const size_t RECORD_HEADER_SIZE = 16;
+const size_t IP_HEADER_SIZE = 20;
+const size_t UDP_HEADER_SIZE = 8;
+
+/* TEST-NET-1 (RFC 5737) addresses, which never clash with the ones of an actual capture. */
+const uint8_t CLIENT_ADDRESS[4] = {192, 0, 2, 1};
+const uint8_t AGENT_ADDRESS[4] = {192, 0, 2, 2};
+
+uint8_t* put_u16(uint8_t* p, uint16_t value)
+{
+    p[0] = uint8_t(value >> 8);
+    p[1] = uint8_t(value);
+    return p + 2;
+}
+
+template<typename T>
+uint8_t* put_native(uint8_t* p, T value)
+{
+    std::memcpy(p, &value, sizeof(value));
+    return p + sizeof(value);
+}
+
+uint16_t ip_checksum(const uint8_t* header)
+{
+    uint32_t sum = 0;
+    for(size_t i = 0; i < IP_HEADER_SIZE; i += 2)
+    {
+        sum += (uint32_t(header[i]) << 8) | header[i + 1];
+    }
+    while(sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+    return uint16_t(~sum);
+}
+
+} // namespace
+
+FrameCapture::FrameCapture()
+: open_(false)
+, file_(nullptr)
+, buffer_()
+, used_(0)
+, client_port_(0)
+, ip_id_(0)
+{
+}
+
+FrameCapture::~FrameCapture()
+{
+    close();
+}
+
+bool FrameCapture::open(const std::string& path, uint16_t client_port)
+{
+    close();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_ = std::fopen(path.c_str(), "wb");
+    if(nullptr == file_)
+    {
+        return false;
+    }
+    buffer_.resize(BUFFER_SIZE);
+    used_ = 0;
+    client_port_ = client_port;
+    ip_id_ = 0;
+
+    /* The file header is in the native byte order, as the magic number tells readers. */
+    uint8_t* p = buffer_.data();
+    p = put_native<uint32_t>(p, PCAP_NANOSECOND_MAGIC);
+    p = put_native<uint16_t>(p, 2);
+    p = put_native<uint16_t>(p, 4);
+    p = put_native<int32_t>(p, 0);
+    p = put_native<uint32_t>(p, 0);
+    p = put_native<uint32_t>(p, PCAP_SNAPLEN);
+    p = put_native<uint32_t>(p, LINKTYPE_RAW);
+    used_ = size_t(p - buffer_.data());
+    open_.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+void FrameCapture::write(Direction direction, const uint8_t* buf, size_t len)
+{
+    if(!is_open())
+    {
+        return;
+    }
+
+    std::chrono::nanoseconds now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch());
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if(nullptr == file_)
+    {
+        return;
+    }
+
+    size_t captured = std::min(len, size_t(PCAP_SNAPLEN) - IP_HEADER_SIZE - UDP_HEADER_SIZE);
+    size_t record_size = RECORD_HEADER_SIZE + IP_HEADER_SIZE + UDP_HEADER_SIZE + captured;
+    if(used_ + record_size > buffer_.size())
+    {
+        flush();
+    }
+
+    uint8_t* p = buffer_.data() + used_;
+    p = put_native<uint32_t>(p, uint32_t(now.count() / 1000000000));
+    p = put_native<uint32_t>(p, uint32_t(now.count() % 1000000000));
+    p = put_native<uint32_t>(p, uint32_t(IP_HEADER_SIZE + UDP_HEADER_SIZE + captured));
+    p = put_native<uint32_t>(p, uint32_t(IP_HEADER_SIZE + UDP_HEADER_SIZE + len));
+
+    bool to_agent = (TO_AGENT == direction);
+    uint8_t* ip = p;
+    *p++ = 0x45;
+    *p++ = 0x00;
+    p = put_u16(p, uint16_t(IP_HEADER_SIZE + UDP_HEADER_SIZE + len));
+    p = put_u16(p, ip_id_++);
+    p = put_u16(p, 0x4000);
+    *p++ = 64;
+    *p++ = 17;
+    p = put_u16(p, 0);
+    std::memcpy(p, to_agent ? CLIENT_ADDRESS : AGENT_ADDRESS, 4);
+    std::memcpy(p + 4, to_agent ? AGENT_ADDRESS : CLIENT_ADDRESS, 4);
+    p += 8;
+    put_u16(ip + 10, ip_checksum(ip));
+
+    /* A null checksum stands for none in IPv4. */
+    p = put_u16(p, to_agent ? client_port_ : AGENT_PORT);
+    p = put_u16(p, to_agent ? AGENT_PORT : client_port_);
+    p = put_u16(p, uint16_t(UDP_HEADER_SIZE + len));
+    p = put_u16(p, 0);
+
+    std::memcpy(p, buf, captured);
+    used_ += record_size;
+}
+
+void FrameCapture::flush()
+{
+    if(0 < used_)
+    {
+        (void) std::fwrite(buffer_.data(), 1, used_, file_);
+        used_ = 0;
+    }
+}
+
+void FrameCapture::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    open_.store(false, std::memory_order_relaxed);
+    if(nullptr != file_)
+    {
+        flush();
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    std::vector<uint8_t>().swap(buffer_);
+}
@@ -0,0 +1,57 @@
+#ifndef IN_TEST_CAPTURE_HPP
+#define IN_TEST_CAPTURE_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/*
+ * Writes the frames exchanged by a client to a pcap file with nanosecond timestamps. Every frame
+ * is wrapped into IPv4/UDP headers between a client and an agent address, so that the direction
+ * is kept and Wireshark dissects the XRCE messages as it would on a UDP link, whatever the actual
+ * transport. Records are appended to a memory buffer which is only written to the file when full,
+ * hence the frame path costs a copy and no system call.
+ */
+class FrameCapture
+{
+public:
+    enum Direction
+    {
+        TO_AGENT,
+        TO_CLIENT
+    };
+
+    static const size_t BUFFER_SIZE = 1 << 20;
+    static const uint16_t AGENT_PORT = 2018;
+
+    FrameCapture();
+
+    virtual ~FrameCapture();
+
+    bool open(const std::string& path, uint16_t client_port);
+
+    void write(Direction direction, const uint8_t* buf, size_t len);
+
+    void close();
+
+    bool is_open() const
+    {
+        return open_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void flush();
+
+    std::atomic<bool> open_;
+    std::mutex mutex_;
+    FILE* file_;
+    std::vector<uint8_t> buffer_;
+    size_t used_;
+    uint16_t client_port_;
+    uint16_t ip_id_;
+};
+
+#endif //IN_TEST_CAPTURE_HPP
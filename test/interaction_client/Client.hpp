@@ -4,6 +4,7 @@
 #include "BigHelloWorld.h"
 #include "Gateway.hpp"
 #include <EntitiesInfo.hpp>
+#include <TestIsolation.hpp>
 #include <TransportInfo.hpp>
 
 #include <uxr/client/client.h>
@@ -41,6 +42,13 @@ public:
     {
     }
 
+    Client(const Impairment& impairment, uint16_t history)
+    : gateway_(impairment)
+    , client_key_(++next_client_key_)
+    , history_(history)
+    {
+    }
+
     virtual ~Client()
     {}
 
@@ -61,7 +69,8 @@ public:
 
         uxrObjectId topic_id = uxr_object_id(id, UXR_TOPIC_ID);
         request_id = uxr_buffer_create_topic_xml(
-            &session_, output_stream_id, topic_id, participant_id, EInfo::topic_xml, flags);
+            &session_, output_stream_id, topic_id, participant_id,
+            with_topic_suffix(EInfo::topic_xml, EInfo::topic_name, topic_suffix_).c_str(), flags);
         ASSERT_NE(UXR_INVALID_REQUEST_ID, request_id);
         uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
         ASSERT_EQ(expected_status, status);
@@ -75,7 +84,8 @@ public:
 
         uxrObjectId datawriter_id = uxr_object_id(id, UXR_DATAWRITER_ID);
         request_id = uxr_buffer_create_datawriter_xml(
-            &session_, output_stream_id, datawriter_id, publisher_id, EInfo::datawriter_xml, flags);
+            &session_, output_stream_id, datawriter_id, publisher_id,
+            with_topic_suffix(EInfo::datawriter_xml, EInfo::topic_name, topic_suffix_).c_str(), flags);
         ASSERT_NE(UXR_INVALID_REQUEST_ID, request_id);
         uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
         ASSERT_EQ(expected_status, status);
@@ -89,7 +99,8 @@ public:
 
         uxrObjectId datareader_id = uxr_object_id(id, UXR_DATAREADER_ID);
         request_id = uxr_buffer_create_datareader_xml(
-            &session_, output_stream_id, datareader_id, subscriber_id, EInfo::datareader_xml, flags);
+            &session_, output_stream_id, datareader_id, subscriber_id,
+            with_topic_suffix(EInfo::datareader_xml, EInfo::topic_name, topic_suffix_).c_str(), flags);
         ASSERT_NE(UXR_INVALID_REQUEST_ID, request_id);
         uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
         ASSERT_EQ(expected_status, status);
@@ -239,12 +250,15 @@ public:
 
         bool deleted = uxr_delete_session(&session_);
 
-        if(0.0f == gateway_.get_lost_value()) //because the agent only send one status to a delete in stream 0.
+        if(!gateway_.is_lossy()) //because the agent only send one status to a delete in stream 0.
         {
             EXPECT_TRUE(deleted);
             EXPECT_EQ(UXR_STATUS_OK, session_.info.last_requested_status);
         }
 
+        // No delayed message may be sent through a closed transport.
+        gateway_.stop();
+
         switch(transport_kind)
         {
             case TransportKind::none:
@@ -268,6 +282,15 @@ public:
         return mtu_;
     }
 
+    /*
+     * Topics created from XML get the suffix appended to their name, so that only the clients of
+     * a test with the same suffix communicate. Set before creating the entities.
+     */
+    void set_topic_suffix(const std::string& suffix)
+    {
+        topic_suffix_ = suffix;
+    }
+
 private:
     void init_common()
     {
@@ -346,6 +369,7 @@ private:
 
     uint32_t client_key_;
     uint16_t history_;
+    std::string topic_suffix_;
 
     uxrUDPTransport udp_transport_;
     uxrUDPPlatform udp_platform_;
@@ -1,4 +1,320 @@
 #include "Gateway.hpp"
 
-std::uniform_real_distribution<float> Gateway::msg_lost_(0.0f, 1.0f);
+#include <algorithm>
 
+ImpairmentChannel::ImpairmentChannel(const Impairment& impairment, uint32_t direction)
+: impairment_(impairment)
+, uniform_(0.0f, 1.0f)
+, bad_state_(false)
+, order_(0)
+, tokens_(double(impairment.bucket))
+, bucket_time_()
+, stats_()
+{
+    if(0 == impairment.seed)
+    {
+        std::random_device rd;
+        random_.seed(rd());
+    }
+    else
+    {
+        std::seed_seq seq{impairment.seed, direction};
+        random_.seed(seq);
+    }
+}
+
+bool ImpairmentChannel::chance(float probability)
+{
+    return (0.0f < probability) && (uniform_(random_) < probability);
+}
+
+bool ImpairmentChannel::is_lost()
+{
+    if(0.0f < impairment_.burst_enter)
+    {
+        bad_state_ = bad_state_ ? !chance(impairment_.burst_exit) : chance(impairment_.burst_enter);
+    }
+    return chance(bad_state_ ? impairment_.burst_loss : impairment_.loss);
+}
+
+ImpairmentChannel::Verdict ImpairmentChannel::admit(const uint8_t* buf, size_t len, Clock::time_point now)
+{
+    if(is_lost())
+    {
+        ++stats_.dropped;
+        return DROPPED;
+    }
+
+    size_t copies = 1;
+    if(chance(impairment_.duplicate))
+    {
+        ++stats_.duplicated;
+        copies = 2;
+    }
+
+    for(size_t i = 0; i < copies; ++i)
+    {
+        std::chrono::microseconds delay = impairment_.delay;
+        if(0 < impairment_.jitter.count())
+        {
+            float offset = 2.0f * uniform_(random_) - 1.0f;
+            delay += std::chrono::microseconds(int64_t(offset * float(impairment_.jitter.count())));
+        }
+        if(chance(impairment_.reorder))
+        {
+            ++stats_.reordered;
+            delay += impairment_.reorder_delay;
+        }
+        delay = std::max(delay, std::chrono::microseconds(0));
+
+        if((1 == copies) && (0 == delay.count()) && (0 == impairment_.rate) && delayed_.empty() && shaped_.empty())
+        {
+            return PASSED;
+        }
+
+        stats_.delayed += (0 < delay.count()) ? 1 : 0;
+        delayed_.push_back(Pending{now + delay, order_++, std::vector<uint8_t>(buf, buf + len)});
+        std::push_heap(delayed_.begin(), delayed_.end(), later);
+    }
+    return QUEUED;
+}
+
+ImpairmentChannel::Clock::time_point ImpairmentChannel::shape(Clock::time_point ready, size_t len)
+{
+    if(0 == impairment_.rate)
+    {
+        return ready;
+    }
+
+    /* The link sends one message after the other, at the rate of the bucket once it is empty. */
+    double bytes_per_ns = double(impairment_.rate) / 8e9;
+    double depth = double(std::max(impairment_.bucket, len));
+    ready = std::max(ready, bucket_time_);
+    tokens_ = std::min(depth, tokens_ + double(std::chrono::nanoseconds(ready - bucket_time_).count()) * bytes_per_ns);
+    bucket_time_ = ready;
+    if(tokens_ >= double(len))
+    {
+        tokens_ -= double(len);
+        return ready;
+    }
+
+    std::chrono::nanoseconds wait(int64_t((double(len) - tokens_) / bytes_per_ns));
+    tokens_ = 0.0;
+    bucket_time_ = ready + wait;
+    return bucket_time_;
+}
+
+bool ImpairmentChannel::pop(Clock::time_point now, std::vector<uint8_t>& message)
+{
+    while(!delayed_.empty() && (delayed_.front().release <= now))
+    {
+        std::pop_heap(delayed_.begin(), delayed_.end(), later);
+        Pending pending = std::move(delayed_.back());
+        delayed_.pop_back();
+        pending.release = shape(pending.release, pending.data.size());
+        shaped_.push_back(std::move(pending));
+    }
+
+    if(shaped_.empty() || (shaped_.front().release > now))
+    {
+        return false;
+    }
+    message.swap(shaped_.front().data);
+    shaped_.pop_front();
+    return true;
+}
+
+ImpairmentChannel::Clock::time_point ImpairmentChannel::next_event() const
+{
+    Clock::time_point next = Clock::time_point::max();
+    if(!delayed_.empty())
+    {
+        next = delayed_.front().release;
+    }
+    if(!shaped_.empty())
+    {
+        next = std::min(next, shaped_.front().release);
+    }
+    return next;
+}
+
+void ImpairmentChannel::clear()
+{
+    delayed_.clear();
+    shaped_.clear();
+}
+
+Gateway::Gateway(float lost)
+: Gateway([lost]() { Impairment impairment; impairment.loss = lost; return impairment; }())
+{
+}
+
+Gateway::Gateway(const Impairment& impairment)
+: impairment_(impairment)
+, output_(impairment_, 0)
+, input_(impairment_, 1)
+, input_message_()
+, running_(false)
+, user_comm_(nullptr)
+{
+}
+
+Gateway::~Gateway()
+{
+    stop();
+}
+
+uxrCommunication* Gateway::monitorize(uxrCommunication* user_comm)
+{
+    user_comm_ = user_comm;
+    communication_.instance = this;
+    communication_.send_msg = send_dispatcher;
+    communication_.recv_msg = recv_dispatcher;
+    communication_.comm_error = user_comm->comm_error;
+    communication_.mtu = user_comm->mtu;
+
+    if(impairment_.is_delayed() && !running_)
+    {
+        running_ = true;
+        timer_ = std::thread(&Gateway::run_timer, this);
+    }
+
+    return &communication_;
+}
+
+bool Gateway::open_capture(const std::string& path, uint16_t client_port)
+{
+    return capture_.open(path, client_port);
+}
+
+void Gateway::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+        output_.clear();
+    }
+    timer_cv_.notify_all();
+    if(timer_.joinable())
+    {
+        timer_.join();
+    }
+    input_.clear();
+    capture_.close();
+}
+
+ImpairmentStats Gateway::get_stats()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    ImpairmentStats stats = output_.get_stats();
+    stats.dropped += input_.get_stats().dropped;
+    stats.duplicated += input_.get_stats().duplicated;
+    stats.delayed += input_.get_stats().delayed;
+    stats.reordered += input_.get_stats().reordered;
+    return stats;
+}
+
+bool Gateway::forward(const uint8_t* buf, size_t len)
+{
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    capture_.write(FrameCapture::TO_AGENT, buf, len);
+    return user_comm_->send_msg(user_comm_->instance, buf, len);
+}
+
+bool Gateway::send(const uint8_t* buf, size_t len)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    switch(output_.admit(buf, len, ImpairmentChannel::Clock::now()))
+    {
+        case ImpairmentChannel::DROPPED:
+            if(impairment_.verbose)
+            {
+                std::cout << "[Message from client lost -> " << len << " bytes lost]" << std::endl;
+            }
+            return false;
+        case ImpairmentChannel::PASSED:
+            lock.unlock();
+            return forward(buf, len);
+        case ImpairmentChannel::QUEUED:
+            break;
+    }
+
+    if(running_)
+    {
+        timer_cv_.notify_one();
+        return true;
+    }
+
+    /* Duplicates of undelayed messages are sent at once. */
+    bool rv = true;
+    std::vector<uint8_t> message;
+    while(output_.pop(ImpairmentChannel::Clock::now(), message))
+    {
+        rv = forward(message.data(), message.size()) && rv;
+    }
+    return rv;
+}
+
+void Gateway::run_timer()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::vector<uint8_t> message;
+    while(running_)
+    {
+        if(output_.pop(ImpairmentChannel::Clock::now(), message))
+        {
+            lock.unlock();
+            (void) forward(message.data(), message.size());
+            lock.lock();
+        }
+        else if(ImpairmentChannel::Clock::time_point::max() == output_.next_event())
+        {
+            timer_cv_.wait(lock);
+        }
+        else
+        {
+            timer_cv_.wait_until(lock, output_.next_event());
+        }
+    }
+}
+
+bool Gateway::recv(uint8_t** buf, size_t* len, int timeout)
+{
+    typedef ImpairmentChannel::Clock Clock;
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeout);
+    do
+    {
+        Clock::time_point now = Clock::now();
+        if(input_.pop(now, input_message_))
+        {
+            *buf = input_message_.data();
+            *len = input_message_.size();
+            capture_.write(FrameCapture::TO_CLIENT, *buf, *len);
+            return true;
+        }
+
+        /* The transport is not waited beyond the release of the next delayed message. */
+        Clock::time_point until = std::min(deadline, input_.next_event());
+        int poll = (until > now) ? int(std::chrono::duration_cast<std::chrono::milliseconds>(until - now).count()) : 0;
+        if(user_comm_->recv_msg(user_comm_->instance, buf, len, poll))
+        {
+            switch(input_.admit(*buf, *len, Clock::now()))
+            {
+                case ImpairmentChannel::DROPPED:
+                    if(impairment_.verbose)
+                    {
+                        std::cout << "[Message from agent lost -> " << *len << " bytes lost]" << std::endl;
+                    }
+                    break;
+                case ImpairmentChannel::PASSED:
+                    capture_.write(FrameCapture::TO_CLIENT, *buf, *len);
+                    return true;
+                case ImpairmentChannel::QUEUED:
+                    break;
+            }
+        }
+    }
+    while(Clock::now() < deadline);
+
+    return false;
+}
@@ -4,108 +4,213 @@
 #include <iostream>
 #include <random>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Capture.hpp"
 #include <uxr/client/core/communication/communication.h>
 
-class Gateway
+/*
+ * Network conditions a Gateway reproduces, independently in each direction. Probabilities are in
+ * [0, 1]. Loss follows a Gilbert-Elliott model: in the good state messages are lost with
+ * probability loss, in the bad state with probability burst_loss, and every message the state
+ * changes with probability burst_enter (good to bad) or burst_exit (bad to good). With burst_enter
+ * null the loss is i.i.d.
+ */
+struct Impairment
 {
-public:
-    Gateway(float lost)
-    : user_comm_(nullptr)
-    , lost_(lost)
+    Impairment()
+    : loss(0.0f)
+    , burst_enter(0.0f)
+    , burst_exit(1.0f)
+    , burst_loss(1.0f)
+    , delay(0)
+    , jitter(0)
+    , reorder(0.0f)
+    , reorder_delay(1000)
+    , duplicate(0.0f)
+    , rate(0)
+    , bucket(0)
+    , seed(0)
+    , verbose(false)
     {
-        std::random_device rd;
-        random_.seed(rd());
     }
 
-    virtual ~Gateway()
+    /* Messages may be dropped, hence a request may not get its status. */
+    bool is_lossy() const
     {
+        return (0.0f < loss) || ((0.0f < burst_enter) && (0.0f < burst_loss));
     }
 
-    uxrCommunication* monitorize(uxrCommunication* user_comm)
+    /* Messages are held back, hence sent from the timer of the Gateway. */
+    bool is_delayed() const
     {
-        user_comm_ = user_comm;
-        communication_.instance = this;
-        communication_.send_msg = send_dispatcher;
-        communication_.recv_msg = recv_dispatcher;
-        communication_.comm_error = user_comm->comm_error;
-        communication_.mtu = user_comm->mtu;
-
-        return &communication_;
+        return (0 < delay.count()) || (0 < jitter.count()) || (0.0f < reorder) || (0 != rate);
     }
 
-    float get_lost_value() const
+    float loss;
+    float burst_enter;
+    float burst_exit;
+    float burst_loss;
+    /* Delay of every message, plus a uniform jitter in [-jitter, jitter]. */
+    std::chrono::microseconds delay;
+    std::chrono::microseconds jitter;
+    /* Probability of a message being held reorder_delay longer, so that the next ones overtake it. */
+    float reorder;
+    std::chrono::microseconds reorder_delay;
+    float duplicate;
+    /* Token bucket: rate in bit/s (0 unlimited) and depth in bytes (0 for a single message). */
+    uint64_t rate;
+    size_t bucket;
+    /* Seed of the random decisions, nondeterministic if 0. */
+    uint32_t seed;
+    /* Whether every dropped message is logged. */
+    bool verbose;
+};
+
+struct ImpairmentStats
+{
+    uint64_t dropped;
+    uint64_t duplicated;
+    uint64_t delayed;
+    uint64_t reordered;
+};
+
+/*
+ * One direction of a Gateway: the loss model, a delay queue ordered by release time and, behind it,
+ * the token bucket which shapes the released messages in order.
+ */
+class ImpairmentChannel
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    enum Verdict
+    {
+        DROPPED,
+        PASSED,
+        QUEUED
+    };
+
+    ImpairmentChannel(const Impairment& impairment, uint32_t direction);
+
+    /* PASSED messages go through as they are, QUEUED ones are copied until their release. */
+    Verdict admit(const uint8_t* buf, size_t len, Clock::time_point now);
+
+    bool pop(Clock::time_point now, std::vector<uint8_t>& message);
+
+    Clock::time_point next_event() const;
+
+    void clear();
+
+    const ImpairmentStats& get_stats() const
     {
-        return lost_;
+        return stats_;
     }
 
 private:
-    static const size_t MESSAGE_LENGTH = 4096;
-    static std::uniform_real_distribution<float> msg_lost_;
+    struct Pending
+    {
+        Clock::time_point release;
+        uint64_t order;
+        std::vector<uint8_t> data;
+    };
 
-    static bool send_dispatcher(void* instance, const uint8_t* buf, size_t len)
+    static bool later(const Pending& lhs, const Pending& rhs)
     {
-        return static_cast<Gateway*>(instance)->send(buf, len);
+        return (lhs.release > rhs.release) || ((lhs.release == rhs.release) && (lhs.order > rhs.order));
     }
 
-    static bool recv_dispatcher(void* instance, uint8_t** buf, size_t* len, int timeout)
+    bool chance(float probability);
+
+    bool is_lost();
+
+    Clock::time_point shape(Clock::time_point ready, size_t len);
+
+    const Impairment& impairment_;
+    std::mt19937 random_;
+    std::uniform_real_distribution<float> uniform_;
+    bool bad_state_;
+    std::vector<Pending> delayed_;
+    std::deque<Pending> shaped_;
+    uint64_t order_;
+    double tokens_;
+    Clock::time_point bucket_time_;
+    ImpairmentStats stats_;
+};
+
+/*
+ * Communication interposed between a session and its transport which impairs the messages of
+ * both directions. Delayed outgoing messages are sent by a timer thread, delayed incoming ones are
+ * delivered by the receptions of the session, which wait no longer than the next release.
+ * The frames which get through may be captured, as their destination gets them.
+ */
+class Gateway
+{
+public:
+    Gateway(float lost);
+
+    Gateway(const Impairment& impairment);
+
+    virtual ~Gateway();
+
+    uxrCommunication* monitorize(uxrCommunication* user_comm);
+
+    /* Frames are captured from the next one sent or received until stop(). */
+    bool open_capture(const std::string& path, uint16_t client_port);
+
+    /* Stops the timer and discards the messages still delayed. Call it before closing the transport. */
+    void stop();
+
+    float get_lost_value() const
     {
-        return static_cast<Gateway*>(instance)->recv(buf, len, timeout);
+        return impairment_.loss;
     }
 
-    bool send(const uint8_t* buf, size_t len)
+    bool is_lossy() const
     {
-        if(get_lost())
-        {
-            std::cout << "[Message from client lost -> " << len << " bytes lost]" << std::endl;
-            return false;
-        }
-
-        return user_comm_->send_msg(user_comm_->instance, buf, len);
+        return impairment_.is_lossy();
     }
 
-    bool recv(uint8_t** buf, size_t* len, int timeout)
+    ImpairmentStats get_stats();
+
+private:
+    static bool send_dispatcher(void* instance, const uint8_t* buf, size_t len)
     {
-        int poll = timeout;
-        do
-        {
-            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-            bool result = user_comm_->recv_msg(user_comm_->instance, buf, len, timeout);
-            std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-            poll -= static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(end - begin).count());
-
-            if(result)
-            {
-                if(get_lost())
-                {
-                    std::cout << "[Message from agent lost -> " << *len << " bytes lost]" << std::endl;
-                }
-                else
-                {
-                    return result;
-                }
-            }
-        }
-        while(0 < poll);
-
-        return false;
+        return static_cast<Gateway*>(instance)->send(buf, len);
     }
 
-    bool get_lost()
+    static bool recv_dispatcher(void* instance, uint8_t** buf, size_t* len, int timeout)
     {
-        if(msg_lost_(random_) < lost_)
-        {
-            return true;
-        }
-
-        return false;
+        return static_cast<Gateway*>(instance)->recv(buf, len, timeout);
     }
 
-    std::mt19937 random_;
+    bool send(const uint8_t* buf, size_t len);
+
+    bool recv(uint8_t** buf, size_t* len, int timeout);
+
+    bool forward(const uint8_t* buf, size_t len);
+
+    void run_timer();
+
+    Impairment impairment_;
+    ImpairmentChannel output_;
+    ImpairmentChannel input_;
+    std::vector<uint8_t> input_message_;
+
+    std::mutex mutex_;
+    /* Serializes the sends of the session and of the timer, as transports are not thread-safe. */
+    std::mutex send_mutex_;
+    std::condition_variable timer_cv_;
+    std::thread timer_;
+    bool running_;
+
+    FrameCapture capture_;
 
     uxrCommunication* user_comm_;
     uxrCommunication communication_;
-
-    float lost_;
 };
 
 #endif //IN_TEST_GATEWAY
@@ -1,7 +1,11 @@
 #ifndef IN_TEST_PERFORMANCE_CLI_HPP_
 #define IN_TEST_PERFORMANCE_CLI_HPP_
 
+#include "PerformanceAgent.hpp"
 #include "PerformanceTest.hpp"
+#if defined(PLATFORM_NAME_LINUX)
+#include "PerformanceReplay.hpp"
+#endif // PLATFORM_NAME_LINUX
 
 #include <EntitiesInfo.hpp>
 #include <TransportInfo.hpp>
@@ -24,15 +28,922 @@ public:
         cli_opt_ = subcommand.add_set("-m,--middleware", kind_, set_, "Select the kind of Middleware", true);
     }
 
+    const std::string& get_name() const { return kind_; }
+
     MiddlewareKind get_kind() const
     {
-        if ("dds" == kind_)
+        if ("dds" == kind_)
+        {
+            return MiddlewareKind::FAST;
+        }
+        else if ("ced" == kind_)
+        {
+            return MiddlewareKind::CED;
+        }
+        else
+        {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+protected:
+    std::string kind_;
+    std::set<std::string> set_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Mode CLI Option
+ *************************************************************************************************/
+class ModeOpt
+{
+public:
+    ModeOpt(CLI::App& subcommand)
+        : kind_{"throughput"}
+        , set_{}
+        , cli_opt_{}
+    {
+        set_.insert("throughput");
+        set_.insert("pingpong");
+        set_.insert("search");
+        set_.insert("scaling");
+        set_.insert("fragmentation");
+        set_.insert("batching");
+        set_.insert("ingest");
+        set_.insert("copy");
+        cli_opt_ = subcommand.add_set("--mode", kind_, set_, "Select the kind of test", true);
+    }
+
+    const std::string& get_name() const { return kind_; }
+
+    TestMode get_mode() const
+    {
+        if ("throughput" == kind_)
+        {
+            return TestMode::THROUGHPUT;
+        }
+        else if ("pingpong" == kind_)
+        {
+            return TestMode::PINGPONG;
+        }
+        else if ("search" == kind_)
+        {
+            return TestMode::SEARCH;
+        }
+        else if ("scaling" == kind_)
+        {
+            return TestMode::SCALING;
+        }
+        else if ("fragmentation" == kind_)
+        {
+            return TestMode::FRAGMENTATION;
+        }
+        else if ("batching" == kind_)
+        {
+            return TestMode::BATCHING;
+        }
+        else if ("ingest" == kind_)
+        {
+            return TestMode::INGEST;
+        }
+        else if ("copy" == kind_)
+        {
+            return TestMode::COPY;
+        }
+        else
+        {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+protected:
+    std::string kind_;
+    std::set<std::string> set_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Pacer CLI Option
+ *************************************************************************************************/
+class PacerOpt
+{
+public:
+    PacerOpt(CLI::App& subcommand)
+        : kind_{"hybrid"}
+        , set_{}
+        , cli_opt_{}
+    {
+        set_.insert("sleep");
+        set_.insert("hybrid");
+        set_.insert("spin");
+        cli_opt_ = subcommand.add_set("--pacer", kind_, set_, "Select the publication rate pacing strategy", true);
+    }
+
+    const std::string& get_name() const { return kind_; }
+
+    PacerStrategy get_strategy() const
+    {
+        if ("sleep" == kind_)
+        {
+            return PacerStrategy::SLEEP;
+        }
+        else if ("hybrid" == kind_)
+        {
+            return PacerStrategy::HYBRID;
+        }
+        else if ("spin" == kind_)
+        {
+            return PacerStrategy::SPIN;
+        }
+        else
+        {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+protected:
+    std::string kind_;
+    std::set<std::string> set_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Receive CLI Options
+ *************************************************************************************************/
+class ReceiveOpts
+{
+public:
+    ReceiveOpts(CLI::App& subcommand)
+        : kind_{"busy"}
+        , set_{}
+        , timeout_{10}
+        , spin_{50}
+        , cli_opt_{}
+        , cli_timeout_opt_{subcommand.add_option("--receive-timeout", timeout_,
+                "Time in milliseconds the subscriber blocks waiting for data", true)}
+        , cli_spin_opt_{subcommand.add_option("--receive-spin", spin_,
+                "Time in microseconds the adaptive subscriber polls after a reception before blocking", true)}
+    {
+        set_.insert("busy");
+        set_.insert("blocking");
+        set_.insert("adaptive");
+        cli_opt_ = subcommand.add_set("--receive", kind_, set_, "Select the subscriber receive strategy", true);
+    }
+
+    const std::string& get_name() const { return kind_; }
+
+    ReceiveStrategy get_strategy() const
+    {
+        if ("busy" == kind_)
+        {
+            return ReceiveStrategy::BUSY;
+        }
+        else if ("blocking" == kind_)
+        {
+            return ReceiveStrategy::BLOCKING;
+        }
+        else if ("adaptive" == kind_)
+        {
+            return ReceiveStrategy::ADAPTIVE;
+        }
+        else
+        {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    uint32_t get_timeout() const { return timeout_; }
+    uint32_t get_spin() const { return spin_; }
+
+protected:
+    std::string kind_;
+    std::set<std::string> set_;
+    uint32_t timeout_;
+    uint32_t spin_;
+    CLI::Option* cli_opt_;
+    CLI::Option* cli_timeout_opt_;
+    CLI::Option* cli_spin_opt_;
+};
+
+/*************************************************************************************************
+ * Stream CLI Options
+ *************************************************************************************************/
+class StreamOpts
+{
+public:
+    StreamOpts(CLI::App& subcommand)
+        : kind_{"best-effort"}
+        , set_{}
+        , history_{PERFORMANCE_HISTORY}
+        , cli_opt_{}
+        , cli_history_opt_{subcommand.add_option("--history", history_,
+                "History depth of the reliable streams, a power of two", true)}
+    {
+        set_.insert("best-effort");
+        set_.insert("reliable");
+        cli_opt_ = subcommand.add_set("--stream", kind_, set_, "Select the stream the samples are sent on", true);
+    }
+
+    const std::string& get_name() const { return kind_; }
+
+    StreamKind get_kind() const
+    {
+        if ("best-effort" == kind_)
+        {
+            return StreamKind::BEST_EFFORT;
+        }
+        else if ("reliable" == kind_)
+        {
+            return StreamKind::RELIABLE;
+        }
+        else
+        {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /*
+     * Reliable streams index their history by sequence number modulo its depth, so that depth must
+     * divide the 16-bit sequence number space.
+     */
+    uint16_t get_history() const
+    {
+        if ((0 == history_) || (0 != (history_ & (history_ - 1))))
+        {
+            std::cerr << "--history must be a power of two" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return history_;
+    }
+
+protected:
+    std::string kind_;
+    std::set<std::string> set_;
+    uint16_t history_;
+    CLI::Option* cli_opt_;
+    CLI::Option* cli_history_opt_;
+};
+
+/*************************************************************************************************
+ * Format CLI Option
+ *************************************************************************************************/
+class FormatOpt
+{
+public:
+    FormatOpt(CLI::App& subcommand)
+        : kind_{"table"}
+        , set_{}
+        , cli_opt_{}
+    {
+        set_.insert("table");
+        set_.insert("csv");
+        set_.insert("json");
+        cli_opt_ = subcommand.add_set("-f,--format", kind_, set_, "Select the format of the results file", true);
+    }
+
+    ResultFormat get_format() const
+    {
+        if ("table" == kind_)
+        {
+            return ResultFormat::TABLE;
+        }
+        else if ("csv" == kind_)
+        {
+            return ResultFormat::CSV;
+        }
+        else if ("json" == kind_)
+        {
+            return ResultFormat::JSON;
+        }
+        else
+        {
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    /* Name of the results file inside the output directory. */
+    std::string get_file_name() const
+    {
+        return ("table" == kind_) ? "out.txt" : "out." + kind_;
+    }
+
+protected:
+    std::string kind_;
+    std::set<std::string> set_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Trace CLI Option
+ *************************************************************************************************/
+class TraceOpt
+{
+public:
+    TraceOpt(CLI::App& subcommand)
+        : path_{}
+        , cli_opt_{subcommand.add_option("--trace", path_, "Binary per-sample trace file path")}
+    {}
+
+    bool is_enable() const { return bool(*cli_opt_); }
+    const std::string& get_path() const { return path_; }
+
+protected:
+    std::string path_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Capture CLI Option
+ *************************************************************************************************/
+class CaptureOpt
+{
+public:
+    CaptureOpt(CLI::App& subcommand)
+        : cli_flag_{subcommand.add_flag("--capture",
+                "Capture the frames of every client into a pcap file of the output directory")}
+    {}
+
+    bool is_enable() const { return bool(*cli_flag_); }
+
+protected:
+    CLI::Option* cli_flag_;
+};
+
+/*************************************************************************************************
+ * OutputDir CLI Option
+ *************************************************************************************************/
+class OutputDir
+{
+public:
+    OutputDir(CLI::App& subcommand)
+        : path_{"./"}
+        , cli_opt_{subcommand.add_option("-o,--output-dir", path_, "Output directory path", true)}
+    {
+        cli_opt_->check(CLI::ExistingPath);
+    }
+
+    bool is_enable() const { return bool(*cli_opt_); }
+    const std::string& get_path() const { return path_; }
+
+protected:
+    std::string path_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * ExperimentTime CLI Option
+ *************************************************************************************************/
+class ExperimentTime
+{
+public:
+    ExperimentTime(CLI::App& subcommand)
+        : time_{10}
+        , cli_opt_{subcommand.add_option("-t,--time", time_, "Experiment time in seconds", true)}
+    {}
+
+    uint16_t get_time() const { return time_; }
+
+protected:
+    uint16_t time_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * MaxLoss CLI Option
+ *************************************************************************************************/
+class MaxLossOpt
+{
+public:
+    MaxLossOpt(CLI::App& subcommand)
+        : max_loss_{1.0}
+        , cli_opt_{subcommand.add_option("--max-loss", max_loss_, "Loss bound (%) of the saturation search", true)}
+    {
+        cli_opt_->check(CLI::Range(0.0, 100.0));
+    }
+
+    double get_max_loss() const { return max_loss_ / 100.0; }
+
+protected:
+    double max_loss_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * LossWindow CLI Option
+ *************************************************************************************************/
+class LossWindowOpt
+{
+public:
+    LossWindowOpt(CLI::App& subcommand)
+        : window_{100}
+        , cli_opt_{subcommand.add_option("--loss-window", window_,
+                "Time window (ms) in which the subscriber losses are counted", true)}
+    {
+        cli_opt_->check(CLI::Range(1, 3600000));
+    }
+
+    int get_window() const { return window_; }
+
+protected:
+    int window_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Sweep CLI Option
+ *************************************************************************************************/
+class SweepOpt
+{
+public:
+    SweepOpt(
+            CLI::App& subcommand,
+            const std::string& name,
+            const std::string& default_values,
+            const std::string& description,
+            size_t min_value)
+        : sizes_{default_values}
+        , name_{long_name(name)}
+        , min_value_{min_value}
+        , cli_opt_{subcommand.add_option(name, sizes_,
+                description + ": comma-separated list of N or FIRST:LAST[:xFACTOR|:STEP]", true)}
+    {}
+
+    /*
+     * Each item is either a single value or a FIRST:LAST range, geometric (xFACTOR, the default
+     * being x2) or linear (STEP). Values below the minimum of the option are rejected.
+     */
+    std::vector<size_t> get_values() const
+    {
+        std::vector<size_t> sizes;
+        std::istringstream list(sizes_);
+        std::string item;
+        while (std::getline(list, item, ','))
+        {
+            if (!parse_item(item, sizes))
+            {
+                std::cerr << "Invalid --" << name_ << " item: '" << item << "'" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+        }
+        if (sizes.empty())
+        {
+            std::cerr << "Empty --" << name_ << " list" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return sizes;
+    }
+
+private:
+    /*
+     * Last name of a CLI11 option such as "-s,--sizes", without its dashes.
+     */
+    static std::string long_name(
+            const std::string& name)
+    {
+        std::string last = name.substr(name.rfind(',') + 1);
+        return last.substr(std::min(last.find_first_not_of('-'), last.size()));
+    }
+
+    static bool parse_size(
+            const std::string& token,
+            size_t& size)
+    {
+        /* strtoull would accept and negate a minus sign. */
+        size_t begin = token.find_first_not_of(" \t");
+        if ((std::string::npos == begin) || ('-' == token[begin]))
+        {
+            return false;
+        }
+
+        char* end = nullptr;
+        unsigned long long value = std::strtoull(token.c_str(), &end, 10);
+        if ('\0' != *end)
+        {
+            return false;
+        }
+        size = size_t(value);
+        return true;
+    }
+
+    bool parse_item(
+            const std::string& item,
+            std::vector<size_t>& sizes) const
+    {
+        std::vector<std::string> tokens;
+        std::istringstream range(item);
+        std::string token;
+        while (std::getline(range, token, ':'))
+        {
+            tokens.push_back(token);
+        }
+
+        size_t first = 0;
+        size_t last = 0;
+        if ((tokens.empty() || tokens.size() > 3)
+            || !parse_size(tokens[0], first)
+            || (first < min_value_))
+        {
+            return false;
+        }
+
+        if (1 == tokens.size())
+        {
+            sizes.push_back(first);
+            return true;
+        }
+
+        if (!parse_size(tokens[1], last) || (last < first))
+        {
+            return false;
+        }
+
+        bool geometric = true;
+        size_t step = 2;
+        if (3 == tokens.size())
+        {
+            std::string step_token = tokens[2];
+            geometric = !step_token.empty() && ('x' == step_token[0]);
+            if (!step_token.empty() && (('x' == step_token[0]) || ('+' == step_token[0])))
+            {
+                step_token.erase(0, 1);
+            }
+            if (!parse_size(step_token, step) || (step < (geometric ? 2u : 1u)))
+            {
+                return false;
+            }
+        }
+
+        size_t size = first;
+        while (size <= last)
+        {
+            sizes.push_back(size);
+            size_t next = geometric ? size * step : size + step;
+            if (next <= size)
+            {
+                break;
+            }
+            size = next;
+        }
+        return true;
+    }
+
+protected:
+    std::string sizes_;
+    std::string name_;
+    size_t min_value_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Sizes CLI Option
+ *************************************************************************************************/
+class SizesOpt : public SweepOpt
+{
+public:
+    SizesOpt(CLI::App& subcommand)
+        : SweepOpt{subcommand, "-s,--sizes", "16:32768:x2,63000", "Message sizes (B)", PerformanceTopic::header_size}
+    {}
+
+    std::vector<size_t> get_sizes() const { return get_values(); }
+};
+
+/*************************************************************************************************
+ * MtuMultiples CLI Option
+ *************************************************************************************************/
+class MtuMultiplesOpt : public SweepOpt
+{
+public:
+    MtuMultiplesOpt(CLI::App& subcommand)
+        : SweepOpt{subcommand, "--mtu-multiples", "1:8192:x2",
+                "Message sizes of the fragmentation test, in MTUs, up to 4 MiB", 1}
+    {}
+
+    std::vector<size_t> get_mtu_multiples() const { return get_values(); }
+};
+
+/*************************************************************************************************
+ * Batch CLI Options
+ *************************************************************************************************/
+class BatchOpts : public SweepOpt
+{
+public:
+    BatchOpts(CLI::App& subcommand)
+        : SweepOpt{subcommand, "--batch", "1:64:x2", "Samples per flush of the batching test", 1}
+        , deadline_{0}
+        , throughput_{1 * std::mega::num}
+        , cli_deadline_opt_{subcommand.add_option("--batch-deadline", deadline_,
+                "Flush a batch once its first sample waited this many microseconds, 0 for never", true)}
+        , cli_throughput_opt_{subcommand.add_option("--batch-throughput", throughput_,
+                "Offered throughput (b/s) of the batching test, 0 for unpaced", true)}
+    {}
+
+    std::vector<size_t> get_batch_sizes() const { return get_values(); }
+    uint32_t get_deadline() const { return deadline_; }
+    uint64_t get_throughput() const { return throughput_; }
+
+protected:
+    uint32_t deadline_;
+    uint64_t throughput_;
+    CLI::Option* cli_deadline_opt_;
+    CLI::Option* cli_throughput_opt_;
+};
+
+/*************************************************************************************************
+ * Impairment CLI Options
+ *************************************************************************************************/
+class ImpairmentOpts
+{
+public:
+    ImpairmentOpts(CLI::App& subcommand)
+        : loss_{0.0f}
+        , burst_enter_{0.0f}
+        , burst_exit_{100.0f}
+        , burst_loss_{100.0f}
+        , delay_{0}
+        , jitter_{0}
+        , reorder_{0.0f}
+        , reorder_delay_{1000}
+        , duplicate_{0.0f}
+        , rate_{0}
+        , bucket_{0}
+        , seed_{0}
+        , cli_loss_opt_{subcommand.add_option("--loss", loss_,
+                "Probability (%) of the Gateway dropping a message, in either direction", true)}
+        , cli_burst_enter_opt_{subcommand.add_option("--burst-enter", burst_enter_,
+                "Probability (%) per message of entering a loss burst, 0 for independent losses", true)}
+        , cli_burst_exit_opt_{subcommand.add_option("--burst-exit", burst_exit_,
+                "Probability (%) per message of leaving a loss burst", true)}
+        , cli_burst_loss_opt_{subcommand.add_option("--burst-loss", burst_loss_,
+                "Probability (%) of dropping a message during a loss burst", true)}
+        , cli_delay_opt_{subcommand.add_option("--delay", delay_,
+                "Delay (us) the Gateway adds to every message", true)}
+        , cli_jitter_opt_{subcommand.add_option("--jitter", jitter_,
+                "Uniform variation (us) of the delay, in either sense", true)}
+        , cli_reorder_opt_{subcommand.add_option("--reorder", reorder_,
+                "Probability (%) of a message being held back and overtaken by the next ones", true)}
+        , cli_reorder_delay_opt_{subcommand.add_option("--reorder-delay", reorder_delay_,
+                "Time (us) a reordered message is held back", true)}
+        , cli_duplicate_opt_{subcommand.add_option("--duplicate", duplicate_,
+                "Probability (%) of the Gateway duplicating a message", true)}
+        , cli_rate_opt_{subcommand.add_option("--link-rate", rate_,
+                "Bandwidth (b/s) of the Gateway in each direction, 0 for unlimited", true)}
+        , cli_bucket_opt_{subcommand.add_option("--link-bucket", bucket_,
+                "Burst (B) the Gateway lets through at once, 0 for a single message", true)}
+        , cli_seed_opt_{subcommand.add_option("--impairment-seed", seed_,
+                "Seed of the Gateway, so that runs are reproducible, 0 for a random one", true)}
+    {
+        cli_loss_opt_->check(CLI::Range(0.0f, 100.0f));
+        cli_burst_enter_opt_->check(CLI::Range(0.0f, 100.0f));
+        cli_burst_exit_opt_->check(CLI::Range(0.0f, 100.0f));
+        cli_burst_loss_opt_->check(CLI::Range(0.0f, 100.0f));
+        cli_delay_opt_->check(CLI::Range(0, 60000000));
+        cli_jitter_opt_->check(CLI::Range(0, 60000000));
+        cli_reorder_opt_->check(CLI::Range(0.0f, 100.0f));
+        cli_reorder_delay_opt_->check(CLI::Range(0, 60000000));
+        cli_duplicate_opt_->check(CLI::Range(0.0f, 100.0f));
+    }
+
+    Impairment get_impairment() const
+    {
+        Impairment impairment;
+        impairment.loss = loss_ / 100.0f;
+        impairment.burst_enter = burst_enter_ / 100.0f;
+        impairment.burst_exit = burst_exit_ / 100.0f;
+        impairment.burst_loss = burst_loss_ / 100.0f;
+        impairment.delay = std::chrono::microseconds{delay_};
+        impairment.jitter = std::chrono::microseconds{jitter_};
+        impairment.reorder = reorder_ / 100.0f;
+        impairment.reorder_delay = std::chrono::microseconds{reorder_delay_};
+        impairment.duplicate = duplicate_ / 100.0f;
+        impairment.rate = rate_;
+        impairment.bucket = bucket_;
+        impairment.seed = seed_;
+        return impairment;
+    }
+
+protected:
+    float loss_;
+    float burst_enter_;
+    float burst_exit_;
+    float burst_loss_;
+    int delay_;
+    int jitter_;
+    float reorder_;
+    int reorder_delay_;
+    float duplicate_;
+    uint64_t rate_;
+    size_t bucket_;
+    uint32_t seed_;
+    CLI::Option* cli_loss_opt_;
+    CLI::Option* cli_burst_enter_opt_;
+    CLI::Option* cli_burst_exit_opt_;
+    CLI::Option* cli_burst_loss_opt_;
+    CLI::Option* cli_delay_opt_;
+    CLI::Option* cli_jitter_opt_;
+    CLI::Option* cli_reorder_opt_;
+    CLI::Option* cli_reorder_delay_opt_;
+    CLI::Option* cli_duplicate_opt_;
+    CLI::Option* cli_rate_opt_;
+    CLI::Option* cli_bucket_opt_;
+    CLI::Option* cli_seed_opt_;
+};
+
+/*************************************************************************************************
+ * Pairs CLI Option
+ *************************************************************************************************/
+class PairsOpt : public SweepOpt
+{
+public:
+    PairsOpt(CLI::App& subcommand)
+        : SweepOpt{subcommand, "--pairs", "1:8:x2", "Publisher/subscriber pairs of the scaling test", 1}
+    {}
+
+    std::vector<size_t> get_pairs() const { return get_values(); }
+};
+
+/*************************************************************************************************
+ * PairThroughput CLI Option
+ *************************************************************************************************/
+class PairThroughputOpt
+{
+public:
+    PairThroughputOpt(CLI::App& subcommand)
+        : throughput_{0}
+        , cli_opt_{subcommand.add_option("--pair-throughput", throughput_,
+                "Offered throughput (b/s) of each pair of the scaling test, 0 for unpaced", true)}
+    {}
+
+    uint64_t get_throughput() const { return throughput_; }
+
+protected:
+    uint64_t throughput_;
+    CLI::Option* cli_opt_;
+};
+
+/*************************************************************************************************
+ * Ingest CLI Options
+ *************************************************************************************************/
+class IngestOpts : public SweepOpt
+{
+public:
+    IngestOpts(CLI::App& subcommand)
+        : SweepOpt{subcommand, "--ingest-rates", "1000:256000:x4,0", "Offered rates (msg/s) of the ingest test, 0 for unpaced", 0}
+        , kind_{"all"}
+        , set_{}
+        , cli_kind_opt_{}
+    {
+        set_.insert("all");
+        set_.insert("write_data");
+        set_.insert("heartbeat");
+        cli_kind_opt_ = subcommand.add_set("--ingest-kind", kind_, set_, "Select the messages of the ingest test", true);
+    }
+
+    std::vector<size_t> get_rates() const { return get_values(); }
+
+    std::vector<IngestKind> get_kinds() const
+    {
+        std::vector<IngestKind> kinds;
+        if (("all" == kind_) || ("write_data" == kind_))
         {
-            return MiddlewareKind::FAST;
+            kinds.push_back(IngestKind::WRITE_DATA);
         }
-        else if ("ced" == kind_)
+        if (("all" == kind_) || ("heartbeat" == kind_))
         {
-            return MiddlewareKind::CED;
+            kinds.push_back(IngestKind::HEARTBEAT);
+        }
+        return kinds;
+    }
+
+protected:
+    std::string kind_;
+    std::set<std::string> set_;
+    CLI::Option* cli_kind_opt_;
+};
+
+/*************************************************************************************************
+ * Copy CLI Options
+ *************************************************************************************************/
+class CopyOpts
+{
+public:
+    CopyOpts(CLI::App& subcommand)
+        : path_{"all"}
+        , set_{}
+        , throughput_{0}
+        , cli_path_opt_{}
+        , cli_throughput_opt_{subcommand.add_option("--copy-throughput", throughput_,
+                "Offered throughput (b/s) of the copy test, 0 for unpaced", true)}
+    {
+        set_.insert("all");
+        set_.insert("struct");
+        set_.insert("topic");
+        set_.insert("blob");
+        set_.insert("in_place");
+        cli_path_opt_ = subcommand.add_set("--copy-path", path_, set_, "Select the write paths of the copy test", true);
+    }
+
+    /*
+     * The in-place path, the reference of the others, is measured whether selected or not.
+     */
+    std::vector<WritePath> get_paths() const
+    {
+        std::vector<WritePath> paths;
+        for (auto path : {WritePath::IN_PLACE, WritePath::BLOB, WritePath::TOPIC, WritePath::STRUCT})
+        {
+            if (("all" == path_) || (get_write_path_name(path) == path_))
+            {
+                paths.push_back(path);
+            }
+        }
+        return paths;
+    }
+
+    uint64_t get_throughput() const { return throughput_; }
+
+protected:
+    std::string path_;
+    std::set<std::string> set_;
+    uint64_t throughput_;
+    CLI::Option* cli_path_opt_;
+    CLI::Option* cli_throughput_opt_;
+};
+
+/*************************************************************************************************
+ * Agent CLI Options
+ *************************************************************************************************/
+class AgentOpts
+{
+public:
+    AgentOpts(CLI::App& subcommand)
+        : pid_{0}
+        , cores_{0}
+        , cli_pid_opt_{subcommand.add_option("--agent-pid", pid_, "PID of the Agent, to report its CPU usage")}
+        , cli_cores_opt_{subcommand.add_option("--agent-cores", cores_,
+                "Repeat the scaling test with the Agent restricted to 1..N cores")}
+    {}
+
+    pid_t get_pid() const { return pid_; }
+
+    size_t get_cores(
+            bool embedded_agent) const
+    {
+        if ((0 != cores_) && (0 == pid_) && !embedded_agent)
+        {
+            std::cerr << "--agent-cores requires --agent-pid or --embedded-agent" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return cores_;
+    }
+
+protected:
+    pid_t pid_;
+    size_t cores_;
+    CLI::Option* cli_pid_opt_;
+    CLI::Option* cli_cores_opt_;
+};
+
+/*************************************************************************************************
+ * Role CLI Options
+ *************************************************************************************************/
+class RoleOpts
+{
+public:
+    RoleOpts(CLI::App& subcommand)
+        : kind_{"threads"}
+        , set_{}
+        , shm_{"/uxr_performance_test"}
+        , cli_opt_{}
+        , cli_shm_opt_{subcommand.add_option("--shm", shm_,
+                "Shared-memory segment of the coordinator and its roles", true)}
+    {
+        set_.insert("threads");
+        set_.insert("pub");
+        set_.insert("sub");
+        set_.insert("coordinator");
+        cli_opt_ = subcommand.add_set("--role", kind_, set_,
+                "Run both clients as threads, or one role of a multi-process throughput test", true);
+    }
+
+    const std::string& get_name() const { return kind_; }
+    const std::string& get_shm() const { return shm_; }
+
+    ProcessRole get_role() const
+    {
+        if ("threads" == kind_)
+        {
+            return ProcessRole::THREADS;
+        }
+        else if ("pub" == kind_)
+        {
+            return ProcessRole::PUBLISHER;
+        }
+        else if ("sub" == kind_)
+        {
+            return ProcessRole::SUBSCRIBER;
+        }
+        else if ("coordinator" == kind_)
+        {
+            return ProcessRole::COORDINATOR;
         }
         else
         {
@@ -40,49 +951,94 @@ public:
         }
     }
 
+    /*
+     * The clients of the publisher and subscriber roles run in their own processes.
+     */
+    bool is_client_role() const
+    {
+        return (ProcessRole::PUBLISHER == get_role()) || (ProcessRole::SUBSCRIBER == get_role());
+    }
+
 protected:
     std::string kind_;
     std::set<std::string> set_;
+    std::string shm_;
     CLI::Option* cli_opt_;
+    CLI::Option* cli_shm_opt_;
 };
 
 /*************************************************************************************************
- * OutputDir CLI Option
+ * EmbeddedAgent CLI Options
  *************************************************************************************************/
-class OutputDir
+class EmbeddedAgentOpts : public SweepOpt
 {
 public:
-    OutputDir(CLI::App& subcommand)
-        : path_{"./"}
-        , cli_opt_{subcommand.add_option("-o,--output-dir", path_, "Output directory path", true)}
+    EmbeddedAgentOpts(CLI::App& subcommand)
+        : SweepOpt{subcommand, "--agent-cpus", "", "CPUs the embedded Agent threads are pinned to", 0}
+        , cli_flag_{subcommand.add_flag("--embedded-agent", "Run the Agent inside the test process")}
+    {}
+
+    bool is_enable() const { return bool(*cli_flag_); }
+
+    std::vector<size_t> get_cpus() const
     {
-        cli_opt_->check(CLI::ExistingPath);
+        return bool(*cli_opt_) ? get_values() : std::vector<size_t>{};
     }
 
-    bool is_enable() const { return bool(*cli_opt_); }
-    const std::string& get_path() const { return path_; }
-
 protected:
-    std::string path_;
-    CLI::Option* cli_opt_;
+    CLI::Option* cli_flag_;
 };
 
 /*************************************************************************************************
- * ExperimentTime CLI Option
+ * Cpus CLI Option
  *************************************************************************************************/
-class ExperimentTime
+class CpusOpt : public SweepOpt
 {
 public:
-    ExperimentTime(CLI::App& subcommand)
-        : time_{10}
-        , cli_opt_{subcommand.add_option("-t,--time", time_, "Experiment time in seconds", true)}
+    CpusOpt(
+            CLI::App& subcommand,
+            const std::string& name,
+            const std::string& description)
+        : SweepOpt{subcommand, name, "", description, 0}
     {}
 
-    uint16_t get_time() const { return time_; }
+    std::vector<size_t> get_cpus() const
+    {
+        return bool(*cli_opt_) ? get_values() : std::vector<size_t>{};
+    }
+};
+
+/*************************************************************************************************
+ * Thread CLI Options
+ *************************************************************************************************/
+class ThreadOpts
+{
+public:
+    ThreadOpts(CLI::App& subcommand)
+        : pub_cpus_opt_{subcommand, "--pub-cpus", "CPUs the publisher (and ping) threads are pinned to"}
+        , sub_cpus_opt_{subcommand, "--sub-cpus", "CPUs the subscriber (and echo) threads are pinned to"}
+        , priority_{0}
+        , warmup_{0}
+        , cli_priority_opt_{subcommand.add_option("--priority", priority_,
+                "SCHED_FIFO priority of the benchmark threads, 0 for the default policy", true)}
+        , cli_warmup_opt_{subcommand.add_option("--warmup", warmup_,
+                "Warm-up time in milliseconds run before every measurement, whose samples are discarded", true)}
+    {
+        cli_priority_opt_->check(CLI::Range(0, 99));
+    }
+
+    ThreadConfig get_publisher_thread() const { return ThreadConfig{pub_cpus_opt_.get_cpus(), priority_}; }
+    ThreadConfig get_subscriber_thread() const { return ThreadConfig{sub_cpus_opt_.get_cpus(), priority_}; }
+    int get_priority() const { return priority_; }
+    uint32_t get_warmup() const { return warmup_; }
 
 protected:
-    uint16_t time_;
-    CLI::Option* cli_opt_;
+    CpusOpt pub_cpus_opt_;
+    CpusOpt sub_cpus_opt_;
+    int priority_;
+    uint32_t warmup_;
+    CLI::Option* cli_priority_opt_;
+    CLI::Option* cli_warmup_opt_;
 };
 
 /*************************************************************************************************
@@ -93,11 +1049,53 @@ class CommonOpts
 public:
     CommonOpts(CLI::App& subcommand)
         : middleware_opt_{subcommand}
+        , mode_opt_{subcommand}
+        , max_loss_opt_{subcommand}
+        , loss_window_opt_{subcommand}
+        , pacer_opt_{subcommand}
+        , receive_opts_{subcommand}
+        , stream_opts_{subcommand}
+        , sizes_opt_{subcommand}
+        , mtu_multiples_opt_{subcommand}
+        , batch_opts_{subcommand}
+        , impairment_opts_{subcommand}
+        , pairs_opt_{subcommand}
+        , pair_throughput_opt_{subcommand}
+        , ingest_opts_{subcommand}
+        , copy_opts_{subcommand}
+        , agent_opts_{subcommand}
+        , embedded_agent_opts_{subcommand}
+        , role_opts_{subcommand}
+        , thread_opts_{subcommand}
+        , format_opt_{subcommand}
+        , trace_opt_{subcommand}
+        , capture_opt_{subcommand}
         , outputdir_opt_{subcommand}
         , experiment_time_{subcommand}
     {}
 
     MiddlewareOpt middleware_opt_;
+    ModeOpt mode_opt_;
+    MaxLossOpt max_loss_opt_;
+    LossWindowOpt loss_window_opt_;
+    PacerOpt pacer_opt_;
+    ReceiveOpts receive_opts_;
+    StreamOpts stream_opts_;
+    SizesOpt sizes_opt_;
+    MtuMultiplesOpt mtu_multiples_opt_;
+    BatchOpts batch_opts_;
+    ImpairmentOpts impairment_opts_;
+    PairsOpt pairs_opt_;
+    PairThroughputOpt pair_throughput_opt_;
+    IngestOpts ingest_opts_;
+    CopyOpts copy_opts_;
+    AgentOpts agent_opts_;
+    EmbeddedAgentOpts embedded_agent_opts_;
+    RoleOpts role_opts_;
+    ThreadOpts thread_opts_;
+    FormatOpt format_opt_;
+    TraceOpt trace_opt_;
+    CaptureOpt capture_opt_;
     OutputDir outputdir_opt_;
     ExperimentTime experiment_time_;
 };
@@ -124,21 +1122,160 @@ public:
 private:
     void test_callback()
     {
-        std::ofstream out(opts_ref_.outputdir_opt_.get_path() + "/out.txt");
-        std::cout.rdbuf(out.rdbuf());
+        if ((ProcessRole::THREADS != opts_ref_.role_opts_.get_role()) && (TestMode::THROUGHPUT != opts_ref_.mode_opt_.get_mode()))
+        {
+            std::cerr << "Only the throughput mode runs as several processes" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+#if !defined(PLATFORM_NAME_LINUX)
+        if (ProcessRole::THREADS != opts_ref_.role_opts_.get_role())
+        {
+            std::cerr << "Multi-process tests are only supported on Linux" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+#endif // PLATFORM_NAME_LINUX
+
+        /* Results are written by the process which runs the test, never by its client roles. */
+        std::ofstream out;
+        std::ofstream histogram_out;
+        if (!opts_ref_.role_opts_.is_client_role())
+        {
+            out.open(opts_ref_.outputdir_opt_.get_path() + "/" + opts_ref_.format_opt_.get_file_name());
+            histogram_out.open(opts_ref_.outputdir_opt_.get_path() + "/histogram.txt");
+        }
+
+        SampleTrace trace;
+        if (opts_ref_.trace_opt_.is_enable() && !trace.open(opts_ref_.trace_opt_.get_path()))
+        {
+            std::cerr << "Unable to open trace file '" << opts_ref_.trace_opt_.get_path() << "'" << std::endl;
+            exit(EXIT_FAILURE);
+        }
 
-        launch_test(
-                std::chrono::seconds{opts_ref_.experiment_time_.get_time()});
+        TestConfig config;
+        config.duration = std::chrono::seconds{opts_ref_.experiment_time_.get_time()};
+        config.mode = opts_ref_.mode_opt_.get_mode();
+        config.max_loss = opts_ref_.max_loss_opt_.get_max_loss();
+        config.pacer = opts_ref_.pacer_opt_.get_strategy();
+        config.receive = opts_ref_.receive_opts_.get_strategy();
+        config.receive_timeout = std::chrono::milliseconds{opts_ref_.receive_opts_.get_timeout()};
+        config.receive_spin = std::chrono::microseconds{opts_ref_.receive_opts_.get_spin()};
+        config.loss_window = std::chrono::milliseconds{opts_ref_.loss_window_opt_.get_window()};
+        config.stream = opts_ref_.stream_opts_.get_kind();
+        config.history = opts_ref_.stream_opts_.get_history();
+        config.sizes = opts_ref_.sizes_opt_.get_sizes();
+        config.mtu_multiples = opts_ref_.mtu_multiples_opt_.get_mtu_multiples();
+        config.batch_sizes = opts_ref_.batch_opts_.get_batch_sizes();
+        config.batch_deadline = std::chrono::microseconds{opts_ref_.batch_opts_.get_deadline()};
+        config.batch_throughput = opts_ref_.batch_opts_.get_throughput();
+        config.impairment = opts_ref_.impairment_opts_.get_impairment();
+        config.capture_dir = opts_ref_.capture_opt_.is_enable() ? opts_ref_.outputdir_opt_.get_path() : std::string{};
+        config.pairs = opts_ref_.pairs_opt_.get_pairs();
+        config.pair_throughput = opts_ref_.pair_throughput_opt_.get_throughput();
+        config.ingest_kinds = opts_ref_.ingest_opts_.get_kinds();
+        config.ingest_rates = opts_ref_.ingest_opts_.get_rates();
+        config.copy_paths = opts_ref_.copy_opts_.get_paths();
+        config.copy_throughput = opts_ref_.copy_opts_.get_throughput();
+        config.agent_pid = opts_ref_.agent_opts_.get_pid();
+        config.embedded_agent = opts_ref_.embedded_agent_opts_.is_enable();
+        config.agent_cores = opts_ref_.agent_opts_.get_cores(config.embedded_agent);
+        config.agent = config.embedded_agent ? &embedded_agent_ : nullptr;
+        config.format = opts_ref_.format_opt_.get_format();
+        config.result_out = &out;
+        config.histogram_out = &histogram_out;
+        config.trace = trace.is_open() ? &trace : nullptr;
+        config.publisher_thread = opts_ref_.thread_opts_.get_publisher_thread();
+        config.subscriber_thread = opts_ref_.thread_opts_.get_subscriber_thread();
+        config.warmup = std::chrono::milliseconds{opts_ref_.thread_opts_.get_warmup()};
+        config.role = opts_ref_.role_opts_.get_role();
+        config.shm_name = opts_ref_.role_opts_.get_shm();
 
-        std::cout.rdbuf(default_buf);
+        add_transport_metadata(config.metadata);
+        config.metadata.add_text("middleware", opts_ref_.middleware_opt_.get_name());
+        config.metadata.add_text("mode", opts_ref_.mode_opt_.get_name());
+        config.metadata.add_text("processes", (ProcessRole::THREADS == config.role) ? "single" : "multiple");
+        config.metadata.add_text("pacer", opts_ref_.pacer_opt_.get_name());
+        config.metadata.add_text("receive", opts_ref_.receive_opts_.get_name());
+        config.metadata.add("receive_timeout", "ms", opts_ref_.receive_opts_.get_timeout());
+        config.metadata.add("receive_spin", "us", opts_ref_.receive_opts_.get_spin());
+        config.metadata.add("loss_window", "ms", opts_ref_.loss_window_opt_.get_window());
+        config.metadata.add_text("stream", (TestMode::FRAGMENTATION == config.mode)
+                ? std::string("reliable") : opts_ref_.stream_opts_.get_name());
+        config.metadata.add("loss", "ppm", std::llround(1e6 * config.impairment.loss));
+        config.metadata.add("burst_enter", "ppm", std::llround(1e6 * config.impairment.burst_enter));
+        config.metadata.add("burst_exit", "ppm", std::llround(1e6 * config.impairment.burst_exit));
+        config.metadata.add("burst_loss", "ppm", std::llround(1e6 * config.impairment.burst_loss));
+        config.metadata.add("delay", "us", config.impairment.delay.count());
+        config.metadata.add("jitter", "us", config.impairment.jitter.count());
+        config.metadata.add("reorder", "ppm", std::llround(1e6 * config.impairment.reorder));
+        config.metadata.add("reorder_delay", "us", config.impairment.reorder_delay.count());
+        config.metadata.add("duplicate", "ppm", std::llround(1e6 * config.impairment.duplicate));
+        config.metadata.add("link_rate", "b/s", config.impairment.rate);
+        config.metadata.add("link_bucket", "B", config.impairment.bucket);
+        config.metadata.add("impairment_seed", "", config.impairment.seed);
+        config.metadata.add("batch_deadline", "us", opts_ref_.batch_opts_.get_deadline());
+        config.metadata.add("duration", "s", opts_ref_.experiment_time_.get_time());
+        config.metadata.add("warmup", "ms", opts_ref_.thread_opts_.get_warmup());
+        config.metadata.add("priority", "", opts_ref_.thread_opts_.get_priority());
+        config.metadata.add_text("pub_cpus", cpu_list(config.publisher_thread.cpus));
+        config.metadata.add_text("sub_cpus", cpu_list(config.subscriber_thread.cpus));
+        add_build_metadata(config.metadata);
+
+        launch_test(config);
+
+        if (trace.is_open() && (0 != trace.get_dropped()))
+        {
+            std::cerr << trace.get_dropped() << " samples could not be traced" << std::endl;
+        }
     }
 
+    virtual void add_transport_metadata(
+            ResultRecord& metadata) const = 0;
+
     virtual void launch_test(
-            std::chrono::seconds duration) = 0;
+            const TestConfig& config) = 0;
+
+protected:
+    /*
+     * Starts the embedded Agent when requested, and returns the IP the clients connect to.
+     */
+    std::string setup_agent(
+            TransportKind transport_kind,
+            const CLI::Option* ip_opt,
+            const std::string& ip,
+            uint16_t port)
+    {
+        /* The embedded Agent of a multi-process test runs in the coordinator. */
+        if (!opts_ref_.embedded_agent_opts_.is_enable() || opts_ref_.role_opts_.is_client_role())
+        {
+            if (!bool(*ip_opt) && !opts_ref_.embedded_agent_opts_.is_enable())
+            {
+                std::cerr << "--ip is required unless --embedded-agent is set" << std::endl;
+                exit(EXIT_FAILURE);
+            }
+            return bool(*ip_opt) ? ip : std::string("127.0.0.1");
+        }
+
+        if (!embedded_agent_.start(transport_kind, port, opts_ref_.middleware_opt_.get_kind(),
+                opts_ref_.embedded_agent_opts_.get_cpus()))
+        {
+            std::cerr << "Unable to start the embedded Agent at port " << port << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        return bool(*ip_opt) ? ip : std::string("127.0.0.1");
+    }
+
+    std::string get_agent_name(
+            const std::string& ip,
+            uint16_t port) const
+    {
+        return (opts_ref_.embedded_agent_opts_.is_enable() ? "embedded:" : ip + ":") + std::to_string(port);
+    }
 
 protected:
     CLI::App* cli_subcommand_;
     const CommonOpts& opts_ref_;
+    EmbeddedAgent embedded_agent_;
 };
 
 
@@ -154,33 +1291,29 @@ public:
         , cli_port_opt_{cli_subcommand_->add_option("-p,--port", port_, "Select Agent port")}
         , common_opts_{*cli_subcommand_}
     {
-        cli_ip_opt_->required(true);
         cli_port_opt_->required(true);
     }
 
     ~UDPSubcommand() = default;
 
 private:
+    void add_transport_metadata(
+            ResultRecord& metadata) const final
+    {
+        metadata.add_text("transport", "udp");
+        metadata.add_text("agent", get_agent_name(ip_, port_));
+    }
+
     void launch_test(
-            std::chrono::seconds duration) final
+            const TestConfig& config) final
     {
+        std::string ip = setup_agent(TransportKind::udp, cli_ip_opt_, ip_, port_);
+
         UDPTransportInfo transport_info;
-        transport_info.ip = ip_.c_str();
+        transport_info.ip = ip.c_str();
         transport_info.port = port_;
 
-        switch (common_opts_.middleware_opt_.get_kind())
-        {
-            case MiddlewareKind::FAST:
-            {
-                run_test_middleware<MiddlewareKind::FAST>(transport_info, duration);
-                break;
-            }
-            case MiddlewareKind::CED:
-            {
-                run_test_middleware<MiddlewareKind::CED>(transport_info, duration);
-                break;
-            }
-        }
+        run_test(common_opts_.middleware_opt_.get_kind(), transport_info, config);
     }
 
 private:
@@ -203,33 +1336,29 @@ public:
         , cli_port_opt_{cli_subcommand_->add_option("-p,--port", port_, "Select Agent port")}
         , common_opts_{*cli_subcommand_}
     {
-        cli_ip_opt_->required(true);
         cli_port_opt_->required(true);
     }
 
     ~TCPSubcommand() = default;
 
 private:
+    void add_transport_metadata(
+            ResultRecord& metadata) const final
+    {
+        metadata.add_text("transport", "tcp");
+        metadata.add_text("agent", get_agent_name(ip_, port_));
+    }
+
     void launch_test(
-            std::chrono::seconds duration) final
+            const TestConfig& config) final
     {
+        std::string ip = setup_agent(TransportKind::tcp, cli_ip_opt_, ip_, port_);
+
         TCPTransportInfo transport_info;
-        transport_info.ip = ip_.c_str();
+        transport_info.ip = ip.c_str();
         transport_info.port = port_;
 
-        switch (common_opts_.middleware_opt_.get_kind())
-        {
-            case MiddlewareKind::FAST:
-            {
-                run_test_middleware<MiddlewareKind::FAST>(transport_info, duration);
-                break;
-            }
-            case MiddlewareKind::CED:
-            {
-                run_test_middleware<MiddlewareKind::CED>(transport_info, duration);
-                break;
-            }
-        }
+        run_test(common_opts_.middleware_opt_.get_kind(), transport_info, config);
     }
 
 private:
@@ -240,5 +1369,203 @@ private:
     CommonOpts common_opts_;
 };
 
+#if defined(PLATFORM_NAME_LINUX)
+/*************************************************************************************************
+ * Serial Subcommand
+ *************************************************************************************************/
+class SerialSubcommand : public ServerSubcommand
+{
+public:
+    SerialSubcommand(CLI::App& app)
+        : ServerSubcommand{app, "serial", "Launch a serial server", common_opts_}
+        , cli_dev_opt_{cli_subcommand_->add_option("-d,--dev", dev_,
+                "Serial device of an external Agent, a pseudo-terminal with an embedded Agent if unset")}
+        , common_opts_{*cli_subcommand_}
+    {}
+
+    ~SerialSubcommand() = default;
+
+private:
+    void add_transport_metadata(
+            ResultRecord& metadata) const final
+    {
+        metadata.add_text("transport", "serial");
+        metadata.add_text("agent", bool(*cli_dev_opt_) ? dev_ : std::string("embedded:pty"));
+    }
+
+    void launch_test(
+            const TestConfig& config) final
+    {
+        if (ProcessRole::THREADS != config.role)
+        {
+            std::cerr << "A serial link cannot be shared by several processes" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        std::string dev = dev_;
+        if (!bool(*cli_dev_opt_)
+            && !embedded_agent_.start_serial(common_opts_.middleware_opt_.get_kind(),
+                    common_opts_.embedded_agent_opts_.get_cpus(), dev))
+        {
+            std::cerr << "Unable to start the embedded serial Agent" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        SerialTransportInfo transport_info;
+        transport_info.dev = dev.c_str();
+        transport_info.remote_addr = 0;
+        transport_info.local_addr = 1;
+
+        TestConfig serial_config = config;
+        serial_config.embedded_agent = !bool(*cli_dev_opt_);
+        run_test(common_opts_.middleware_opt_.get_kind(), transport_info, serial_config);
+    }
+
+private:
+    std::string dev_;
+    CLI::Option* cli_dev_opt_;
+    CommonOpts common_opts_;
+};
+
+/*************************************************************************************************
+ * Replay Subcommand
+ *
+ * Replays the client frames of a capture to a fresh embedded Agent, started again for every
+ * repetition so that the sessions of the capture are created from scratch.
+ *************************************************************************************************/
+class ReplaySubcommand
+{
+public:
+    ReplaySubcommand(CLI::App& app)
+        : cli_subcommand_{app.add_subcommand("replay", "Replay a capture to an embedded Agent")}
+        , capture_{}
+        , transport_{"udp"}
+        , transport_set_{"udp", "tcp"}
+        , port_{2018}
+        , capture_port_{FrameCapture::AGENT_PORT}
+        , speed_{"original"}
+        , speed_set_{"original", "scaled", "fast"}
+        , scale_{1.0}
+        , idle_{500}
+        , repeat_{1}
+        , cli_capture_opt_{cli_subcommand_->add_option("capture", capture_, "Capture file (pcap)")}
+        , cli_transport_opt_{cli_subcommand_->add_set("-t,--transport", transport_, transport_set_,
+                "Transport of the embedded Agent", true)}
+        , cli_port_opt_{cli_subcommand_->add_option("-p,--port", port_, "Port of the embedded Agent", true)}
+        , cli_capture_port_opt_{cli_subcommand_->add_option("--capture-port", capture_port_,
+                "UDP port of the Agent in the capture", true)}
+        , cli_speed_opt_{cli_subcommand_->add_set("--speed", speed_, speed_set_,
+                "Frames sent at their capture time, at a time scaled by --scale, or back to back", true)}
+        , cli_scale_opt_{cli_subcommand_->add_option("--scale", scale_,
+                "Speed factor of a scaled replay, 2 being twice as fast as captured", true)}
+        , cli_idle_opt_{cli_subcommand_->add_option("--idle", idle_,
+                "Time (ms) without replies after which the Agent is done", true)}
+        , cli_repeat_opt_{cli_subcommand_->add_option("--repeat", repeat_, "Number of replays", true)}
+        , middleware_opt_{*cli_subcommand_}
+        , pacer_opt_{*cli_subcommand_}
+        , agent_cpus_opt_{*cli_subcommand_, "--agent-cpus", "CPUs the embedded Agent threads are pinned to"}
+        , format_opt_{*cli_subcommand_}
+        , outputdir_opt_{*cli_subcommand_}
+    {
+        cli_capture_opt_->required(true);
+        cli_scale_opt_->check(CLI::Range(0.001, 1000.0));
+        cli_idle_opt_->check(CLI::Range(1, 60000));
+        cli_repeat_opt_->check(CLI::Range(1, 1000000));
+        cli_subcommand_->callback(std::bind(&ReplaySubcommand::replay_callback, this));
+    }
+
+private:
+    void replay_callback()
+    {
+        ReplayCapture capture;
+        if (!CaptureReader::load(capture_, capture_port_, capture) || capture.frames.empty())
+        {
+            std::cerr << "No frame to the Agent in capture '" << capture_ << "'" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+
+        TransportKind transport_kind = ("tcp" == transport_) ? TransportKind::tcp : TransportKind::udp;
+        ReplaySpeed speed = ("fast" == speed_) ? ReplaySpeed::FAST
+                : ("scaled" == speed_) ? ReplaySpeed::SCALED : ReplaySpeed::ORIGINAL;
+
+        ResultRecord metadata;
+        metadata.add_text("mode", "replay");
+        metadata.add_text("transport", transport_);
+        metadata.add_text("agent", "embedded:" + std::to_string(port_));
+        metadata.add_text("middleware", middleware_opt_.get_name());
+        metadata.add_text("capture", capture_);
+        metadata.add("capture_clients", "", capture.clients);
+        metadata.add("capture_frames", "", capture.frames.size());
+        metadata.add("capture_bytes", "B", capture.bytes);
+        metadata.add("capture_skipped", "", capture.skipped);
+        metadata.add("capture_time", "us",
+                std::chrono::duration_cast<std::chrono::microseconds>(capture.frames.back().timestamp).count());
+        metadata.add_text("speed", speed_);
+        metadata.add("scale", "", scale_, 3);
+        metadata.add_text("pacer", pacer_opt_.get_name());
+        metadata.add_text("agent_cpus", cpu_list(agent_cpus_opt_.get_cpus()));
+        add_build_metadata(metadata);
+
+        std::ofstream out(outputdir_opt_.get_path() + "/" + format_opt_.get_file_name());
+        std::unique_ptr<ResultWriter> writer = ResultWriter::create(format_opt_.get_format(), out, metadata);
+
+        for (uint32_t i = 0; i < repeat_; ++i)
+        {
+            EmbeddedAgent agent;
+            TrafficReplay replay(transport_kind, pacer_opt_.get_strategy());
+            if (!agent.start(transport_kind, port_, middleware_opt_.get_kind(), agent_cpus_opt_.get_cpus())
+                || !replay.connect("127.0.0.1", port_, capture.clients))
+            {
+                std::cerr << "Unable to replay to the embedded Agent at port " << port_ << std::endl;
+                exit(EXIT_FAILURE);
+            }
+
+            ReplayResult result = replay.run(capture, speed, scale_, std::chrono::milliseconds(idle_));
+            double seconds = double(result.processing_time.count()) / double(std::nano::den);
+
+            ResultRecord record;
+            record.add("run", "", writer->begin_run());
+            record.add("frames", "", result.frames);
+            record.add("bytes", "B", result.bytes);
+            record.add("send_errors", "", result.send_errors);
+            record.add("replies", "", result.replies);
+            record.add("reply_bytes", "B", result.reply_bytes);
+            record.add("send_time", "us", std::chrono::duration_cast<std::chrono::microseconds>(result.send_time).count());
+            record.add("processing_time", "us",
+                    std::chrono::duration_cast<std::chrono::microseconds>(result.processing_time).count());
+            record.add("agent_throughput", "msg/s", double(result.frames) / seconds, 1);
+            record.add("agent_throughput", "b/s", uint64_t(double(8 * result.bytes) / seconds));
+            add_usage_fields(record, "agent", result.agent_usage);
+            writer->write(record);
+        }
+    }
+
+private:
+    CLI::App* cli_subcommand_;
+    std::string capture_;
+    std::string transport_;
+    std::set<std::string> transport_set_;
+    uint16_t port_;
+    uint16_t capture_port_;
+    std::string speed_;
+    std::set<std::string> speed_set_;
+    double scale_;
+    uint32_t idle_;
+    uint32_t repeat_;
+    CLI::Option* cli_capture_opt_;
+    CLI::Option* cli_transport_opt_;
+    CLI::Option* cli_port_opt_;
+    CLI::Option* cli_capture_port_opt_;
+    CLI::Option* cli_speed_opt_;
+    CLI::Option* cli_scale_opt_;
+    CLI::Option* cli_idle_opt_;
+    CLI::Option* cli_repeat_opt_;
+    MiddlewareOpt middleware_opt_;
+    PacerOpt pacer_opt_;
+    CpusOpt agent_cpus_opt_;
+    FormatOpt format_opt_;
+    OutputDir outputdir_opt_;
+};
+#endif // PLATFORM_NAME_LINUX
 
 #endif // IN_TEST_PERFORMANCE_CLI_HPP_
@@ -0,0 +1,236 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEAGENT_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEAGENT_HPP
+
+#include <EntitiesInfo.hpp>
+#include <TransportInfo.hpp>
+
+#if defined(PLATFORM_NAME_LINUX)
+#include <uxr/agent/transport/udp/UDPServerLinux.hpp>
+#include <uxr/agent/transport/tcp/TCPServerLinux.hpp>
+#include <uxr/agent/transport/serial/SerialServerLinux.hpp>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#elif defined(PLATFORM_NAME_WINDOWS)
+#include <uxr/agent/transport/udp/UDPServerWindows.hpp>
+#include <uxr/agent/transport/tcp/TCPServerWindows.hpp>
+#endif
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*************************************************************************************************
+ * Embedded Agent
+ *
+ * Agent running in the performance-test process, as the integration fixtures do. Its threads
+ * inherit the affinity of the thread which starts it, so it is temporarily restricted to the
+ * requested CPUs while the agent spawns them.
+ *************************************************************************************************/
+class EmbeddedAgent
+{
+public:
+    EmbeddedAgent()
+        : agent_{}
+        , cpus_{}
+        , fd_{-1}
+    {}
+
+    ~EmbeddedAgent()
+    {
+        if (agent_)
+        {
+            (void) agent_->stop();
+        }
+    }
+
+    bool start(
+            TransportKind transport_kind,
+            uint16_t port,
+            MiddlewareKind middleware_kind,
+            const std::vector<size_t>& cpus);
+
+#if defined(PLATFORM_NAME_LINUX)
+    /*
+     * Serial Agent on the master side of a new pseudo-terminal, whose slave device is returned
+     * in dev for the clients to open.
+     */
+    bool start_serial(
+            MiddlewareKind middleware_kind,
+            const std::vector<size_t>& cpus,
+            std::string& dev);
+#endif
+
+    /*
+     * Restarts the Agent with its threads pinned to the first cores CPUs. Its sessions are lost,
+     * hence no client may be connected.
+     */
+    bool restrict_cores(
+            size_t cores);
+
+    /*
+     * Restarts the Agent pinned to the CPUs it was started with, undoing restrict_cores().
+     */
+    bool restore_cores();
+
+private:
+    static eprosima::uxr::Middleware::Kind get_middleware(
+            MiddlewareKind middleware_kind);
+
+    bool run(
+            const std::vector<size_t>& cpus);
+
+    static bool pin_current_thread(
+            const std::vector<size_t>& cpus);
+
+private:
+    std::unique_ptr<eprosima::uxr::Server> agent_;
+    std::vector<size_t> cpus_;
+    int fd_;
+};
+
+inline bool EmbeddedAgent::start(
+        TransportKind transport_kind,
+        uint16_t port,
+        MiddlewareKind middleware_kind,
+        const std::vector<size_t>& cpus)
+{
+    eprosima::uxr::Middleware::Kind middleware = get_middleware(middleware_kind);
+    switch (transport_kind)
+    {
+        case TransportKind::udp:
+            agent_.reset(new eprosima::uxr::UDPv4Agent(port, middleware));
+            break;
+        case TransportKind::tcp:
+            agent_.reset(new eprosima::uxr::TCPv4Agent(port, middleware));
+            break;
+        default:
+            std::cerr << "Not supported transport for the embedded Agent" << std::endl;
+            return false;
+    }
+
+    cpus_ = cpus;
+    return run(cpus);
+}
+
+#if defined(PLATFORM_NAME_LINUX)
+inline bool EmbeddedAgent::start_serial(
+        MiddlewareKind middleware_kind,
+        const std::vector<size_t>& cpus,
+        std::string& dev)
+{
+    fd_ = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((-1 == fd_) || (0 != grantpt(fd_)) || (0 != unlockpt(fd_)) || (nullptr == ptsname(fd_)))
+    {
+        return false;
+    }
+    dev = ptsname(fd_);
+
+    fcntl(fd_, F_SETPIPE_SZ, 4096);
+
+    struct termios attr;
+    tcgetattr(fd_, &attr);
+    cfmakeraw(&attr);
+    tcflush(fd_, TCIOFLUSH);
+    tcsetattr(fd_, TCSANOW, &attr);
+
+    agent_.reset(new eprosima::uxr::SerialAgent(fd_, 0x00, get_middleware(middleware_kind)));
+    cpus_ = cpus;
+    return run(cpus);
+}
+#endif
+
+inline bool EmbeddedAgent::restrict_cores(
+        size_t cores)
+{
+#if defined(PLATFORM_NAME_LINUX)
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if (!agent_ || (0 == cores) || (long(cores) > online))
+    {
+        return false;
+    }
+
+    std::vector<size_t> cpus;
+    for (size_t i = 0; i < cores; ++i)
+    {
+        cpus.push_back(i);
+    }
+    return agent_->stop() && run(cpus);
+#else
+    (void) cores;
+    return false;
+#endif
+}
+
+inline bool EmbeddedAgent::restore_cores()
+{
+#if defined(PLATFORM_NAME_LINUX)
+    return agent_ && agent_->stop() && run(cpus_);
+#else
+    return false;
+#endif
+}
+
+inline eprosima::uxr::Middleware::Kind EmbeddedAgent::get_middleware(
+        MiddlewareKind middleware_kind)
+{
+    switch (middleware_kind)
+    {
+        case MiddlewareKind::CED:
+            return eprosima::uxr::Middleware::Kind::CED;
+        case MiddlewareKind::FAST:
+        default:
+            return eprosima::uxr::Middleware::Kind::FAST;
+    }
+}
+
+inline bool EmbeddedAgent::run(
+        const std::vector<size_t>& cpus)
+{
+#if defined(PLATFORM_NAME_LINUX)
+    cpu_set_t previous_cpus;
+    bool pinned = !cpus.empty() && (0 == sched_getaffinity(0, sizeof(previous_cpus), &previous_cpus));
+    if (pinned && !pin_current_thread(cpus))
+    {
+        std::cerr << "Unable to pin the embedded Agent threads" << std::endl;
+        pinned = false;
+    }
+#else
+    if (!cpus.empty())
+    {
+        std::cerr << "Pinning of the embedded Agent threads is not supported on this platform" << std::endl;
+    }
+#endif
+
+    bool rv = agent_->run();
+
+#if defined(PLATFORM_NAME_LINUX)
+    if (pinned)
+    {
+        (void) sched_setaffinity(0, sizeof(previous_cpus), &previous_cpus);
+    }
+#endif
+    return rv;
+}
+
+inline bool EmbeddedAgent::pin_current_thread(
+        const std::vector<size_t>& cpus)
+{
+#if defined(PLATFORM_NAME_LINUX)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (auto cpu : cpus)
+    {
+        CPU_SET(cpu, &cpu_set);
+    }
+    return 0 == sched_setaffinity(0, sizeof(cpu_set), &cpu_set);
+#else
+    (void) cpus;
+    return false;
+#endif
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEAGENT_HPP
@@ -1,32 +1,42 @@
 #!/usr/bin/python
 
+# Plots the throughput test results written with --format csv. The header is repeated whenever
+# the columns change, so rows of other modes and repeated headers are skipped.
+
+import csv
 import sys
 import matplotlib.pyplot as plt
 
 data = []
 with open(sys.argv[1], 'r') as f:
-    next(f)
-    for line in f:
-        data.append(list(map(lambda x: int(x), line.split())))
+    for row in csv.DictReader(f):
+        if row.get('lost') not in (None, 'lost') and 'throughput_pub_b/s' in row:
+            data.append(row)
+
+def column(row, name):
+    return float(row[name])
 
-payload_sizes = map(lambda x: 2**x, range(4, 16))
-payload_sizes.append(63000)
+def loss_percentage(row):
+    expected = column(row, 'received') + column(row, 'lost')
+    return 100 * column(row, 'lost') / expected if expected > 0 else 0
+
+payload_sizes = sorted(set(map(lambda x: int(x['message_size_B']), data)))
 
 latency_avg = []
 latency_std = []
 throughput = []
 
 for s in payload_sizes:
-    filtered_data = list(filter(lambda x: x[0] == s, data))
-    filtered_row = filter(lambda x: x[3] == min(map(lambda x: x[3], filtered_data)), filtered_data)[0]
-    latency_avg.append(filtered_row[3] / 1e3)
-    latency_std.append(filtered_row[4] / 1e3)
-    throughput.append(max(map(lambda x: x[2], filtered_data)) / 1e6)
+    filtered_data = list(filter(lambda x: int(x['message_size_B']) == s, data))
+    filtered_row = min(filtered_data, key=lambda x: column(x, 'latency_ns'))
+    latency_avg.append(column(filtered_row, 'latency_ns') / 1e3)
+    latency_std.append(column(filtered_row, 'jitter_ns') / 1e3)
+    throughput.append(max(map(lambda x: column(x, 'throughput_sub_b/s'), filtered_data)) / 1e6)
 
-    latency = [x[3] / 1e3 for x in filtered_data]
-    throught_pub = [x[1] / 1e6 for x in filtered_data]
-    throught_sub = [x[2] / 1e6 for x in filtered_data]
-    lost_percentage = list(map(lambda x, y: max(((x - y) / x) * 100, 0), map(lambda x: float(x), throught_pub), map(lambda x: float(x), throught_sub)))
+    latency = [column(x, 'latency_ns') / 1e3 for x in filtered_data]
+    throught_pub = [column(x, 'throughput_pub_b/s') / 1e6 for x in filtered_data]
+    lost_percentage = [loss_percentage(x) for x in filtered_data]
+    window_loss_max = [column(x, 'window_loss_max_%') for x in filtered_data]
 
     fig, ax = plt.subplots()
     ax.scatter(throught_pub, latency)
@@ -36,6 +46,16 @@ for s in payload_sizes:
     plt.title("Latency vs through (%i B of payload)" %s)
     plt.show()
 
+    # A worst window well above the average loss means the losses come in bursts.
+    fig, ax = plt.subplots()
+    ax.plot(throught_pub, lost_percentage, 'o-', label="Run")
+    ax.plot(throught_pub, window_loss_max, 'x--', label="Worst window")
+    ax.set_ylabel("Loss (%)")
+    ax.set_xlabel("Throughput (Mbps)")
+    ax.legend()
+    plt.title("Loss vs through (%i B of payload)" %s)
+    plt.show()
+
 fig, ax = plt.subplots()
 plt.errorbar(payload_sizes, latency_avg, yerr=latency_std, uplims=True, lolims=True)
 ax.set_xlabel("Payload size (B)")
@@ -52,4 +72,4 @@ ax.set_ylabel("Throughput (Mbps)")
 ax.set_ylim(bottom=0)
 ax.set_xticks([0, 15000, 30000, 45000, 60000, 75000])
 ax.set_xscale("log")
-plt.show()
\ No newline at end of file
+plt.show()
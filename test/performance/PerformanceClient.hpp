@@ -1,12 +1,20 @@
 #ifndef IN_TEST_PERFORMANCECLIENT_HPP
 #define IN_TEST_PERFORMANCECLIENT_HPP
 
+#include "PerformanceMonitor.hpp"
+#include "PerformanceSystem.hpp"
+#include "PerformanceTopic.hpp"
+#include "PerformanceTrace.hpp"
+#include <Gateway.hpp>
+#include <TestIsolation.hpp>
 #include <TransportInfo.hpp>
 
 #include <uxr/client/client.h>
 
 #include <memory>
 #include <chrono>
+#include <iostream>
+#include <string>
 #ifndef _WIN32
 #include <stdio.h>
 #include <fcntl.h>
@@ -14,6 +22,21 @@
 
 #define PERFORMANCE_HISTORY 16
 
+/* Message header (with client key), submessage header and WRITE_DATA object request. */
+#define PERFORMANCE_WRITE_DATA_OVERHEAD 16
+
+/* Length kept by the reliable streams in front of every message of their history. */
+#define PERFORMANCE_RELIABLE_SLOT_OVERHEAD 4
+
+/* Message header (with client key) and FRAGMENT submessage header of every fragment. */
+#define PERFORMANCE_FRAGMENT_OVERHEAD 12
+
+enum class StreamKind : uint8_t
+{
+    BEST_EFFORT,
+    RELIABLE
+};
+
 inline bool operator == (const uxrObjectId& lhs, const uxrObjectId& rhs)
 {
     return (lhs.id == rhs.id) && (lhs.type == rhs.type);
@@ -28,18 +51,142 @@ class PerformanceClient
 {
 public:
     PerformanceClient()
-        : client_key_{++next_client_key_}
+        : trace_{nullptr}
+        , trace_run_{0}
+        , cpu_time_{0}
+        , usage_{}
+        , cpu_begin_{0}
+        , usage_begin_{}
+        , client_key_{++next_client_key_}
+        , stream_kind_{StreamKind::BEST_EFFORT}
+        , history_{PERFORMANCE_HISTORY}
+        , impairment_{}
+        , capture_dir_{}
         , transport_kind_{TransportKind::none}
+        , mtu_{0}
     {}
 
     virtual ~PerformanceClient() = default;
 
+    /*
+     * Client keys are numbered per process. A process running a single role of a test skips the
+     * keys of the clients which precede it, so that the keys are the same as in a single process.
+     */
+    static void skip_client_keys(
+            uint32_t count)
+    {
+        next_client_key_ += count;
+    }
+
     template<typename T>
     bool init(
             const T& transport_info);
 
     bool fini();
 
+    void reserve_payload(
+            size_t max_size)
+    {
+        arena_.reserve(max_size);
+    }
+
+    /*
+     * The reliable stream fragments the samples larger than one message, as long as all their
+     * fragments fit in its history at once. One slot is kept free for the next sample.
+     */
+    size_t get_max_payload() const
+    {
+        if (StreamKind::RELIABLE != stream_kind_)
+        {
+            return mtu_ - PERFORMANCE_WRITE_DATA_OVERHEAD;
+        }
+        size_t slots = (1 < history_) ? size_t(history_ - 1) : 1;
+        return slots * get_fragment_payload(mtu_) - PERFORMANCE_WRITE_DATA_OVERHEAD;
+    }
+
+    static size_t get_fragment_payload(
+            size_t mtu)
+    {
+        return mtu - PERFORMANCE_RELIABLE_SLOT_OVERHEAD - PERFORMANCE_FRAGMENT_OVERHEAD;
+    }
+
+    size_t get_mtu() const { return mtu_; }
+    uint16_t get_history() const { return history_; }
+
+    /*
+     * CPU time the thread running the last publication or subscription spent on it.
+     */
+    std::chrono::nanoseconds get_cpu_time() const { return cpu_time_; }
+
+    /*
+     * Resources the thread running the last publication or subscription used meanwhile.
+     */
+    const ResourceUsage& get_usage() const { return usage_; }
+    size_t get_input_buffer_size() const { return mtu_ * history_ * UXR_CONFIG_MAX_INPUT_RELIABLE_STREAMS; }
+    const StreamStats& get_stream_stats() const { return monitor_.get_stats(); }
+
+    /*
+     * Session of the client, whose communication also carries the messages sent bypassing it.
+     */
+    uxrSession& get_session() { return session_; }
+
+    /*
+     * Stream the samples are written to and requested on: best-effort 0x01 or reliable 0x80,
+     * whose history (a power of two) also sizes the input reliable stream. Set before init().
+     */
+    void set_stream(
+            StreamKind stream_kind,
+            uint16_t history)
+    {
+        stream_kind_ = stream_kind;
+        history_ = history;
+    }
+
+    /*
+     * Messages are impaired in both directions by a Gateway placed between the session and its
+     * transport, which is left out when the impairment does nothing. Set before init().
+     */
+    void set_impairment(
+            const Impairment& impairment)
+    {
+        impairment_ = impairment;
+    }
+
+    /*
+     * The frames the client exchanges are captured into a pcap file of the given directory, named
+     * after the client key. An empty directory disables the capture. Set before init().
+     */
+    void set_capture(
+            const std::string& dir)
+    {
+        capture_dir_ = dir;
+    }
+
+    template<typename T>
+    static size_t get_transport_mtu();
+
+    /*
+     * Samples of the following runs are recorded into trace, tagged with run. A null trace
+     * disables recording.
+     */
+    void set_trace(
+            SampleTrace* trace,
+            uint32_t run)
+    {
+        trace_ = trace;
+        trace_run_ = run;
+    }
+
+    /*
+     * A client with a topic suffix creates its entities on its own topics, so that several pairs
+     * of clients can share an agent without receiving each other's samples. Set before init().
+     */
+    void set_topic_suffix(
+            const std::string& suffix)
+    {
+        topic_suffix_ = suffix;
+    }
+
 private:
     virtual bool create_entities() = 0;
 
@@ -49,6 +196,9 @@ private:
     void setup_streams(
             size_t mtu);
 
+    uxrCommunication* monitorize(
+            uxrCommunication* comm);
+
     static void status_callback_dispatcher(
             uxrSession* session,
             uxrObjectId object_id,
@@ -62,6 +212,36 @@ private:
             uint16_t request_id,
             uint8_t status);
 
+protected:
+    bool is_reliable() const { return StreamKind::RELIABLE == stream_kind_; }
+
+    uint8_t get_data_stream_raw() const { return is_reliable() ? XRCE_RELIABLE_STREAM_ID : 0x01; }
+
+    std::string with_topic_suffix(
+            const char* xml,
+            const char* topic_name) const;
+
+    bool wait_status(
+            uxrObjectId object_id,
+            uint16_t request_id);
+
+    /*
+     * CPU time and resource usage of the calling thread are measured between both calls.
+     */
+    void begin_usage()
+    {
+        (void) read_thread_usage(usage_begin_);
+        cpu_begin_ = thread_cpu_time();
+    }
+
+    void end_usage()
+    {
+        cpu_time_ = thread_cpu_time() - cpu_begin_;
+        ResourceUsage usage_end = {};
+        (void) read_thread_usage(usage_end);
+        usage_ = usage_delta(usage_end, usage_begin_);
+    }
+
 protected:
     uxrSession session_;
 
@@ -69,11 +249,28 @@ protected:
     uxrObjectId last_object_id_;
     uint16_t last_request_id_;
 
+    PerformanceArena arena_;
+    SampleTrace* trace_;
+    uint32_t trace_run_;
+    std::string topic_suffix_;
+    StreamMonitor monitor_;
+    std::chrono::nanoseconds cpu_time_;
+    ResourceUsage usage_;
+
 private:
+    std::chrono::nanoseconds cpu_begin_;
+    ResourceUsage usage_begin_;
+
     static uint32_t next_client_key_;
     uint32_t client_key_;
+    StreamKind stream_kind_;
+    uint16_t history_;
+    Impairment impairment_;
+    std::string capture_dir_;
+    std::unique_ptr<Gateway> gateway_;
 
     TransportKind transport_kind_;
+    size_t mtu_;
     uxrUDPTransport udp_transport_;
     uxrUDPPlatform udp_platform_;
     uxrTCPTransport tcp_transport_;
@@ -86,6 +283,26 @@ private:
     std::unique_ptr<uint8_t[]> input_reliable_stream_buffer_;
 };
 
+template<>
+inline size_t PerformanceClient::get_transport_mtu<UDPTransportInfo>()
+{
+    return UXR_CONFIG_UDP_TRANSPORT_MTU;
+}
+
+template<>
+inline size_t PerformanceClient::get_transport_mtu<TCPTransportInfo>()
+{
+    return UXR_CONFIG_TCP_TRANSPORT_MTU;
+}
+
+#ifndef _WIN32
+template<>
+inline size_t PerformanceClient::get_transport_mtu<SerialTransportInfo>()
+{
+    return UXR_CONFIG_SERIAL_TRANSPORT_MTU;
+}
+#endif // _WIN32
+
 template<>
 inline bool PerformanceClient::init<UDPTransportInfo>(
         const UDPTransportInfo& transport_info)
@@ -94,8 +311,8 @@ inline bool PerformanceClient::init<UDPTransportInfo>(
     transport_kind_ = TransportKind::udp;
     if (uxr_init_udp_transport(&udp_transport_, &udp_platform_, transport_info.ip, transport_info.port))
     {
-        uxr_init_session(&session_, &udp_transport_.comm, client_key_);
-        if (init_common(UXR_CONFIG_UDP_TRANSPORT_MTU))
+        uxr_init_session(&session_, monitorize(&udp_transport_.comm), client_key_);
+        if (init_common(get_transport_mtu<UDPTransportInfo>()))
         {
             rv = create_entities();
         }
@@ -111,8 +328,8 @@ inline bool PerformanceClient::init<TCPTransportInfo>(
     transport_kind_ = TransportKind::tcp;
     if (uxr_init_tcp_transport(&tcp_transport_, &tcp_platform_, transport_info.ip, transport_info.port))
     {
-        uxr_init_session(&session_, &tcp_transport_.comm, client_key_);
-        if (init_common(UXR_CONFIG_TCP_TRANSPORT_MTU))
+        uxr_init_session(&session_, monitorize(&tcp_transport_.comm), client_key_);
+        if (init_common(get_transport_mtu<TCPTransportInfo>()))
         {
             rv = create_entities();
         }
@@ -130,8 +347,8 @@ inline bool PerformanceClient::init<SerialTransportInfo>(
     int fd = open(transport_info.dev, O_RDWR | O_NOCTTY | O_NONBLOCK);
     if (uxr_init_serial_transport(&serial_transport_, &serial_platform_, fd, transport_info.remote_addr, transport_info.local_addr))
     {
-        uxr_init_session(&session_, &serial_transport_.comm, client_key_);
-        if (init_common(UXR_CONFIG_SERIAL_TRANSPORT_MTU))
+        uxr_init_session(&session_, monitorize(&serial_transport_.comm), client_key_);
+        if (init_common(get_transport_mtu<SerialTransportInfo>()))
         {
             rv = create_entities();
         }
@@ -143,7 +360,15 @@ inline bool PerformanceClient::init<SerialTransportInfo>(
 inline bool PerformanceClient::fini()
 {
     bool rv = false;
-    if (TransportKind::none != transport_kind_ && uxr_delete_session(&session_))
+    bool deleted = (TransportKind::none != transport_kind_) && uxr_delete_session(&session_);
+
+    /* The messages the Gateway still delays would be sent through a closed transport. */
+    if (gateway_)
+    {
+        gateway_->stop();
+    }
+
+    if (deleted)
     {
         switch (transport_kind_)
         {
@@ -165,9 +390,17 @@ inline bool PerformanceClient::fini()
     return rv;
 }
 
+inline std::string PerformanceClient::with_topic_suffix(
+        const char* xml,
+        const char* topic_name) const
+{
+    return ::with_topic_suffix(xml, topic_name, topic_suffix_);
+}
+
 inline bool PerformanceClient::init_common(
         size_t mtu)
 {
+    mtu_ = mtu;
     uxr_set_status_callback(&session_, status_callback_dispatcher, this);
     setup_streams(mtu);
     return uxr_create_session(&session_);
@@ -177,8 +410,8 @@ inline void PerformanceClient::setup_streams(
         size_t mtu)
 {
     output_best_effort_stream_buffer_.reset(new uint8_t[mtu * UXR_CONFIG_MAX_OUTPUT_BEST_EFFORT_STREAMS]{0});
-    output_reliable_stream_buffer_.reset(new uint8_t[mtu * PERFORMANCE_HISTORY * UXR_CONFIG_MAX_OUTPUT_RELIABLE_STREAMS]{0});
-    input_reliable_stream_buffer_.reset(new uint8_t[mtu * PERFORMANCE_HISTORY * UXR_CONFIG_MAX_INPUT_RELIABLE_STREAMS]{0});
+    output_reliable_stream_buffer_.reset(new uint8_t[mtu * history_ * UXR_CONFIG_MAX_OUTPUT_RELIABLE_STREAMS]{0});
+    input_reliable_stream_buffer_.reset(new uint8_t[mtu * history_ * UXR_CONFIG_MAX_INPUT_RELIABLE_STREAMS]{0});
     for(size_t i = 0; i < 1; ++i)
     {
         uint8_t* buffer = output_best_effort_stream_buffer_.get() + mtu * i;
@@ -190,16 +423,48 @@ inline void PerformanceClient::setup_streams(
     }
     for(size_t i = 0; i < 1; ++i)
     {
-        uint8_t* buffer = output_reliable_stream_buffer_.get() + mtu * PERFORMANCE_HISTORY * i;
-        (void) uxr_create_output_reliable_stream(&session_, buffer , mtu * PERFORMANCE_HISTORY, PERFORMANCE_HISTORY);
+        uint8_t* buffer = output_reliable_stream_buffer_.get() + mtu * history_ * i;
+        (void) uxr_create_output_reliable_stream(&session_, buffer , mtu * history_, history_);
     }
     for(size_t i = 0; i < 1; ++i)
     {
-        uint8_t* buffer = input_reliable_stream_buffer_.get() + mtu * PERFORMANCE_HISTORY * i;
-        (void) uxr_create_input_reliable_stream(&session_, buffer, mtu * PERFORMANCE_HISTORY, PERFORMANCE_HISTORY);
+        uint8_t* buffer = input_reliable_stream_buffer_.get() + mtu * history_ * i;
+        (void) uxr_create_input_reliable_stream(&session_, buffer, mtu * history_, history_);
     }
 }
 
+/*
+ * Only reliable runs are monitored, so that best-effort ones keep a direct path to the transport.
+ * The Gateway sits below the monitor, which therefore also counts the messages it drops. Captured
+ * frames are numbered with a UDP port per client, so that the captures of a test can be merged.
+ */
+inline uxrCommunication* PerformanceClient::monitorize(
+        uxrCommunication* comm)
+{
+    bool impaired = impairment_.is_lossy() || impairment_.is_delayed() || (0.0f < impairment_.duplicate);
+    gateway_.reset((impaired || !capture_dir_.empty()) ? new Gateway(impairment_) : nullptr);
+    if (!capture_dir_.empty())
+    {
+        char name[32];
+        snprintf(name, sizeof(name), "/capture_%08X.pcap", client_key_);
+        if (!gateway_->open_capture(capture_dir_ + name, uint16_t(0xC000 | (client_key_ & 0x3FFF))))
+        {
+            std::cerr << "Unable to open capture file '" << capture_dir_ << name << "'" << std::endl;
+        }
+    }
+    comm = gateway_ ? gateway_->monitorize(comm) : comm;
+    return is_reliable() ? monitor_.monitorize(comm) : comm;
+}
+
+inline bool PerformanceClient::wait_status(
+        uxrObjectId object_id,
+        uint16_t request_id)
+{
+    uint8_t status;
+    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
+    return (UXR_STATUS_OK == status) && (last_object_id_ == object_id) && (last_request_id_ == request_id);
+}
+
 inline void PerformanceClient::status_callback_dispatcher(
         uxrSession* session,
         uxrObjectId object_id,
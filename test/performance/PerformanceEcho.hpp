@@ -0,0 +1,196 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEECHO_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEECHO_HPP
+
+#include "PerformanceClient.hpp"
+#include <EntitiesInfo.hpp>
+
+#include <atomic>
+#include <thread>
+
+/*
+ * Echo role of the ping-pong test: republishes every sample received on the performance topic,
+ * byte by byte, on the echo topic. Samples are not deserialized so that the echo adds as little
+ * processing as possible to the measured round-trip.
+ */
+template<MiddlewareKind MK>
+class PerformanceEcho : public PerformanceClient
+{
+public:
+    PerformanceEcho() {}
+
+    ~PerformanceEcho() override = default;
+
+    /*
+     * Echoes samples while running is set, so that the last ping of a run is never left
+     * unanswered because both roles measured a slightly different duration.
+     */
+    void echo(
+            const std::atomic<bool>& running);
+
+    uint64_t get_msg_count() { return msg_count_; }
+
+private:
+    bool create_entities() final;
+
+    static void topic_callback_dispatcher(
+            uxrSession* session,
+            uxrObjectId object_id,
+            uint16_t request_id,
+            uxrStreamId stream_id,
+            ucdrBuffer* serialization,
+            void* args);
+
+    void topic_callback(
+            uxrSession* session,
+            uxrObjectId object_id,
+            uint16_t request_id,
+            uxrStreamId stream_id,
+            ucdrBuffer* serialization);
+
+private:
+    static uint16_t entities_prefix_;
+    static uint16_t echo_entities_prefix_;
+    uint64_t msg_count_;
+};
+
+template<MiddlewareKind MK>
+inline void PerformanceEcho<MK>::echo(
+        const std::atomic<bool>& running)
+{
+    msg_count_ = 0;
+    monitor_.reset_stats();
+
+    uxr_set_topic_callback(&session_, topic_callback_dispatcher, this);
+
+    uxrStreamId output_stream_id = uxr_stream_id(0, UXR_RELIABLE_STREAM, UXR_OUTPUT_STREAM);
+    uxrStreamId input_stream_id = uxr_stream_id_from_raw(get_data_stream_raw(), UXR_INPUT_STREAM);
+    uxrObjectId datareader_id = uxr_object_id(entities_prefix_, UXR_DATAREADER_ID);
+
+    uxrDeliveryControl delivery_control = {};
+    delivery_control.max_samples = UXR_MAX_SAMPLES_UNLIMITED;
+    uxr_buffer_request_data(&session_, output_stream_id, datareader_id, input_stream_id, &delivery_control);
+
+    while (running)
+    {
+        uxr_run_session_until_timeout(&session_, 0);
+        (void) uxr_flash_output_streams(&session_);
+    }
+}
+
+template<MiddlewareKind MK>
+inline bool PerformanceEcho<MK>::create_entities()
+{
+    using EInfo = EntitiesInfo<MK>;
+
+    uint8_t flags = 0x00;
+    uxrStreamId output_stream_id = uxr_stream_id_from_raw(0x01, UXR_OUTPUT_STREAM);
+    uint16_t request_id;
+
+    uxrObjectId participant_id = uxr_object_id(entities_prefix_, UXR_PARTICIPANT_ID);
+    request_id = uxr_buffer_create_participant_xml(
+        &session_, output_stream_id, participant_id, 11, EInfo::participant_xml, flags);
+    if (!wait_status(participant_id, request_id))
+    {
+        return false;
+    }
+
+    uxrObjectId topic_id = uxr_object_id(entities_prefix_, UXR_TOPIC_ID);
+    request_id = uxr_buffer_create_topic_xml(
+        &session_, output_stream_id, topic_id, participant_id,
+        with_topic_suffix(EInfo::topic_xml, EInfo::topic_name).c_str(), flags);
+    if (!wait_status(topic_id, request_id))
+    {
+        return false;
+    }
+
+    uxrObjectId subscriber_id = uxr_object_id(entities_prefix_, UXR_SUBSCRIBER_ID);
+    request_id = uxr_buffer_create_subscriber_xml(
+        &session_, output_stream_id, subscriber_id, participant_id, EInfo::subscriber_xml, flags);
+    if (!wait_status(subscriber_id, request_id))
+    {
+        return false;
+    }
+
+    uxrObjectId datareader_id = uxr_object_id(entities_prefix_, UXR_DATAREADER_ID);
+    request_id = uxr_buffer_create_datareader_xml(
+        &session_, output_stream_id, datareader_id, subscriber_id,
+        with_topic_suffix(EInfo::datareader_xml, EInfo::topic_name).c_str(), flags);
+    if (!wait_status(datareader_id, request_id))
+    {
+        return false;
+    }
+
+    uxrObjectId echo_topic_id = uxr_object_id(echo_entities_prefix_, UXR_TOPIC_ID);
+    request_id = uxr_buffer_create_topic_xml(
+        &session_, output_stream_id, echo_topic_id, participant_id,
+        with_topic_suffix(EInfo::echo_topic_xml, EInfo::echo_topic_name).c_str(), flags);
+    if (!wait_status(echo_topic_id, request_id))
+    {
+        return false;
+    }
+
+    uxrObjectId publisher_id = uxr_object_id(echo_entities_prefix_, UXR_PUBLISHER_ID);
+    request_id = uxr_buffer_create_publisher_xml(
+        &session_, output_stream_id, publisher_id, participant_id, EInfo::publisher_xml, flags);
+    if (!wait_status(publisher_id, request_id))
+    {
+        return false;
+    }
+
+    uxrObjectId datawriter_id = uxr_object_id(echo_entities_prefix_, UXR_DATAWRITER_ID);
+    request_id = uxr_buffer_create_datawriter_xml(
+        &session_, output_stream_id, datawriter_id, publisher_id,
+        with_topic_suffix(EInfo::echo_datawriter_xml, EInfo::echo_topic_name).c_str(), flags);
+    if (!wait_status(datawriter_id, request_id))
+    {
+        return false;
+    }
+
+    return true;
+}
+
+template<MiddlewareKind MK>
+inline void PerformanceEcho<MK>::topic_callback_dispatcher(
+        uxrSession* session,
+        uxrObjectId object_id,
+        uint16_t request_id,
+        uxrStreamId stream_id,
+        ucdrBuffer* serialization,
+        void* args)
+{
+    static_cast<PerformanceEcho*>(args)->topic_callback(session, object_id, request_id, stream_id, serialization);
+}
+
+template<MiddlewareKind MK>
+inline void PerformanceEcho<MK>::topic_callback(
+        uxrSession* session,
+        uxrObjectId object_id,
+        uint16_t request_id,
+        uxrStreamId stream_id,
+        ucdrBuffer* serialization)
+{
+    (void) session;
+    (void) object_id;
+    (void) request_id;
+    (void) stream_id;
+
+    uxrStreamId output_stream_id = uxr_stream_id_from_raw(get_data_stream_raw(), UXR_OUTPUT_STREAM);
+    uxrObjectId datawriter_id = uxr_object_id(echo_entities_prefix_, UXR_DATAWRITER_ID);
+
+    uint32_t length = uint32_t(serialization->final - serialization->iterator);
+
+    ucdrBuffer ub;
+    if (uxr_prepare_output_stream(&session_, output_stream_id, datawriter_id, &ub, length)
+        && ucdr_serialize_array_uint8_t(&ub, serialization->iterator, length))
+    {
+        ++msg_count_;
+    }
+}
+
+template<MiddlewareKind MK>
+uint16_t PerformanceEcho<MK>::entities_prefix_ = 0x0000;
+
+template<MiddlewareKind MK>
+uint16_t PerformanceEcho<MK>::echo_entities_prefix_ = 0x0001;
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEECHO_HPP
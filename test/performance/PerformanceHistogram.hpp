@@ -0,0 +1,257 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEHISTOGRAM_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEHISTOGRAM_HPP
+
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+/*************************************************************************************************
+ * Latency Histogram
+ *
+ * HDR-style log-bucketed histogram. Values below 2^sub_bucket_bits are stored exactly, above that
+ * each power-of-two range is split into 2^sub_bucket_bits linear sub-buckets, so the relative
+ * error of any reported value is below 1 / 2^sub_bucket_bits (~1.6%). Storage is inline, hence
+ * recording never allocates and can be done from the topic callback.
+ *************************************************************************************************/
+class LatencyHistogram
+{
+public:
+    static constexpr uint32_t sub_bucket_bits = 6;
+    static constexpr uint32_t sub_bucket_count = uint32_t(1) << sub_bucket_bits;
+    static constexpr uint32_t bucket_count = (64 - sub_bucket_bits + 1) * sub_bucket_count;
+
+    LatencyHistogram()
+    {
+        reset();
+    }
+
+    void reset();
+
+    void record(
+            uint64_t value)
+    {
+        record_n(value, 1);
+    }
+
+    void record_n(
+            uint64_t value,
+            uint64_t count);
+
+    void merge(
+            const LatencyHistogram& other);
+
+    uint64_t get_count() const { return total_; }
+    uint64_t get_min() const { return (0 == total_) ? 0 : min_; }
+    uint64_t get_max() const { return max_; }
+    double get_mean() const { return (0 == total_) ? 0.0 : sum_ / double(total_); }
+
+    uint64_t get_percentile(
+            double percentile) const;
+
+    /*
+     * The dump is a header line followed by one "<bucket_lower_bound> <count>" line per non-empty
+     * bucket. Since every line is additive, dumps from several runs or roles can be merged either
+     * with load() or by summing counts per value with any external tool.
+     */
+    void dump(
+            std::ostream& os,
+            const std::string& label) const;
+
+    bool load(
+            std::istream& is);
+
+private:
+    static uint32_t bucket_index(
+            uint64_t value);
+
+    static uint64_t bucket_lower(
+            uint32_t index);
+
+    static uint64_t bucket_upper(
+            uint32_t index);
+
+private:
+    std::array<uint64_t, bucket_count> counts_;
+    uint64_t total_;
+    uint64_t min_;
+    uint64_t max_;
+    double sum_;
+};
+
+inline void LatencyHistogram::reset()
+{
+    counts_.fill(0);
+    total_ = 0;
+    min_ = std::numeric_limits<uint64_t>::max();
+    max_ = 0;
+    sum_ = 0.0;
+}
+
+inline void LatencyHistogram::record_n(
+        uint64_t value,
+        uint64_t count)
+{
+    if (0 == count)
+    {
+        return;
+    }
+    counts_[bucket_index(value)] += count;
+    total_ += count;
+    sum_ += double(value) * double(count);
+    min_ = (value < min_) ? value : min_;
+    max_ = (value > max_) ? value : max_;
+}
+
+inline void LatencyHistogram::merge(
+        const LatencyHistogram& other)
+{
+    for (uint32_t i = 0; i < bucket_count; ++i)
+    {
+        counts_[i] += other.counts_[i];
+    }
+    total_ += other.total_;
+    sum_ += other.sum_;
+    min_ = (other.min_ < min_) ? other.min_ : min_;
+    max_ = (other.max_ > max_) ? other.max_ : max_;
+}
+
+inline uint64_t LatencyHistogram::get_percentile(
+        double percentile) const
+{
+    if (0 == total_)
+    {
+        return 0;
+    }
+
+    uint64_t target = uint64_t(std::ceil(percentile / 100.0 * double(total_)));
+    target = (0 == target) ? 1 : target;
+
+    uint64_t accumulated = 0;
+    for (uint32_t i = 0; i < bucket_count; ++i)
+    {
+        accumulated += counts_[i];
+        if (accumulated >= target)
+        {
+            uint64_t upper = bucket_upper(i);
+            return (upper < max_) ? upper : max_;
+        }
+    }
+    return max_;
+}
+
+inline void LatencyHistogram::dump(
+        std::ostream& os,
+        const std::string& label) const
+{
+    os << "histogram " << label << " " << total_ << " " << get_min() << " " << max_ << " " << sum_ << std::endl;
+    for (uint32_t i = 0; i < bucket_count; ++i)
+    {
+        if (0 != counts_[i])
+        {
+            os << bucket_lower(i) << " " << counts_[i] << std::endl;
+        }
+    }
+    os << "end" << std::endl;
+}
+
+inline bool LatencyHistogram::load(
+        std::istream& is)
+{
+    std::string line;
+    while (std::getline(is, line) && (0 != line.compare(0, 9, "histogram")))
+    {}
+    if (!is)
+    {
+        return false;
+    }
+
+    /* Header: "histogram <label> <count> <min> <max> <sum>". */
+    std::istringstream header(line);
+    std::string tag;
+    std::string label;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+    double sum;
+    if (!(header >> tag >> label >> total >> min >> max >> sum))
+    {
+        return false;
+    }
+
+    LatencyHistogram loaded;
+    while (std::getline(is, line) && ("end" != line))
+    {
+        std::istringstream bucket(line);
+        uint64_t value;
+        uint64_t count;
+        if (!(bucket >> value >> count))
+        {
+            return false;
+        }
+        loaded.counts_[bucket_index(value)] += count;
+        loaded.total_ += count;
+    }
+
+    if (loaded.total_ != total)
+    {
+        return false;
+    }
+    loaded.min_ = (0 == total) ? std::numeric_limits<uint64_t>::max() : min;
+    loaded.max_ = max;
+    loaded.sum_ = sum;
+    merge(loaded);
+    return true;
+}
+
+inline uint32_t LatencyHistogram::bucket_index(
+        uint64_t value)
+{
+    if (value < sub_bucket_count)
+    {
+        return uint32_t(value);
+    }
+
+    uint32_t msb = 0;
+#if defined(__GNUC__) || defined(__clang__)
+    msb = uint32_t(63 - __builtin_clzll(value));
+#else
+    for (uint64_t v = value; v > 1; v >>= 1)
+    {
+        ++msb;
+    }
+#endif
+    uint32_t shift = msb - sub_bucket_bits;
+    return (shift + 1) * sub_bucket_count + uint32_t(value >> shift) - sub_bucket_count;
+}
+
+inline uint64_t LatencyHistogram::bucket_lower(
+        uint32_t index)
+{
+    if (index < sub_bucket_count)
+    {
+        return index;
+    }
+
+    uint32_t shift = index / sub_bucket_count - 1;
+    uint64_t sub_bucket = uint64_t(index % sub_bucket_count) + sub_bucket_count;
+    return sub_bucket << shift;
+}
+
+inline uint64_t LatencyHistogram::bucket_upper(
+        uint32_t index)
+{
+    if (index < sub_bucket_count)
+    {
+        return index;
+    }
+
+    uint32_t shift = index / sub_bucket_count - 1;
+    uint64_t sub_bucket = uint64_t(index % sub_bucket_count) + sub_bucket_count;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEHISTOGRAM_HPP
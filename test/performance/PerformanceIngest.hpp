@@ -0,0 +1,342 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEINGEST_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEINGEST_HPP
+
+#include "PerformancePacer.hpp"
+#include "PerformanceSystem.hpp"
+#include "PerformanceTopic.hpp"
+
+#include <uxr/agent/types/XRCETypes.hpp>
+#include <uxr/agent/message/OutputMessage.hpp>
+#include <uxr/client/client.h>
+#include <ucdr/microcdr.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+/*
+ * Submessages a load generator sends to the agent, each one with a reply which tells it was
+ * processed: the samples of a WRITE_DATA are delivered to a subscriber, and a HEARTBEAT of a
+ * reliable stream is answered with an ACKNACK.
+ */
+enum class IngestKind : uint8_t
+{
+    WRITE_DATA,
+    HEARTBEAT
+};
+
+inline const char* get_ingest_kind_name(
+        IngestKind kind)
+{
+    return (IngestKind::WRITE_DATA == kind) ? "write_data" : "heartbeat";
+}
+
+struct IngestResult
+{
+    uint64_t sent;
+    uint64_t send_errors;
+    uint64_t replies;
+    std::chrono::nanoseconds elapsed;
+    ResourceUsage usage;
+};
+
+/*************************************************************************************************
+ * Ingest Message
+ *
+ * Message of an existing client session, serialized with the types of the Agent as the
+ * cross-serialization tests do. It is built once and then sent again and again, only patching the
+ * sequence number of its stream and, for samples, the one of the topic, so that sending it costs
+ * no serialization at all.
+ *************************************************************************************************/
+class IngestMessage
+{
+public:
+    static constexpr uint8_t none_stream_id = 0x00;
+    static constexpr uint8_t best_effort_stream_id = 0x01;
+    static constexpr uint8_t reliable_stream_id = 0x80;
+
+    IngestMessage()
+        : buffer_{}
+        , topic_seq_offset_{0}
+        , topic_seq_{0}
+        , reply_id_{0}
+    {}
+
+    /*
+     * WRITE_DATA of a topic sample of the given size to a DataWriter, on the best-effort stream.
+     */
+    bool build_write_data(
+            const uxrSession& session,
+            uxrObjectId datawriter_id,
+            size_t size);
+
+    /*
+     * HEARTBEAT of the reliable stream, on the none stream, with nothing to acknowledge.
+     */
+    bool build_heartbeat(
+            const uxrSession& session);
+
+    /*
+     * The message with the given stream sequence number and, for samples, the next topic one.
+     */
+    const std::vector<uint8_t>& next(
+            uint16_t stream_seq);
+
+    size_t size() const { return buffer_.size(); }
+
+    /*
+     * Submessage with which the agent replies to the session. Samples are delivered to the
+     * subscribers of the topic instead, so no DATA ever reaches the session which writes them.
+     */
+    uint8_t get_reply_id() const { return reply_id_; }
+
+private:
+    static dds::xrce::MessageHeader get_header(
+            const uxrSession& session,
+            uint8_t stream_id);
+
+    template<typename T>
+    void build(
+            const dds::xrce::MessageHeader& header,
+            dds::xrce::SubmessageId submessage_id,
+            const T& payload);
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t topic_seq_offset_;
+    uint32_t topic_seq_;
+    uint8_t reply_id_;
+};
+
+constexpr uint8_t IngestMessage::none_stream_id;
+constexpr uint8_t IngestMessage::best_effort_stream_id;
+constexpr uint8_t IngestMessage::reliable_stream_id;
+
+inline dds::xrce::MessageHeader IngestMessage::get_header(
+        const uxrSession& session,
+        uint8_t stream_id)
+{
+    dds::xrce::ClientKey client_key = {{session.info.key[0], session.info.key[1], session.info.key[2], session.info.key[3]}};
+    dds::xrce::MessageHeader header;
+    header.client_key(client_key);
+    header.session_id(session.info.id);
+    header.stream_id(stream_id);
+    header.sequence_nr(0);
+    return header;
+}
+
+template<typename T>
+inline void IngestMessage::build(
+        const dds::xrce::MessageHeader& header,
+        dds::xrce::SubmessageId submessage_id,
+        const T& payload)
+{
+    dds::xrce::SubmessageHeader subheader;
+    subheader.submessage_id(submessage_id);
+    subheader.flags(0x01);
+    subheader.submessage_length(uint16_t(payload.getCdrSerializedSize()));
+
+    size_t message_size = header.getCdrSerializedSize() +
+                          subheader.getCdrSerializedSize() +
+                          payload.getCdrSerializedSize();
+
+    eprosima::uxr::OutputMessage output(header, message_size);
+    output.append_submessage(submessage_id, payload, 0x0001);
+    buffer_.assign(output.get_buf(), output.get_buf() + output.get_len());
+}
+
+inline bool IngestMessage::build_write_data(
+        const uxrSession& session,
+        uxrObjectId datawriter_id,
+        size_t size)
+{
+    /* The sequence number of the topic is located by serializing a marker in its place. */
+    const uint32_t marker = 0xA5C3E1F0;
+    std::vector<uint8_t> data(size - PerformanceTopic::header_size, 0);
+    std::vector<uint8_t> sample(size);
+    PerformanceTopic topic = {marker, {0, 0}, data.data(), size};
+    ucdrBuffer ub;
+    ucdr_init_buffer(&ub, sample.data(), uint32_t(sample.size()));
+    if (!topic.serialize(ub))
+    {
+        return false;
+    }
+
+    uint8_t object_id[2];
+    uxr_object_id_to_raw(datawriter_id, object_id);
+
+    dds::xrce::WRITE_DATA_Payload_Data payload;
+    payload.request_id() = {0x00, 0x00};
+    payload.object_id() = {object_id[0], object_id[1]};
+    payload.data().serialized_data() = sample;
+    build(get_header(session, best_effort_stream_id), dds::xrce::WRITE_DATA, payload);
+
+    uint8_t marker_bytes[sizeof(marker)];
+    memcpy(marker_bytes, sample.data(), sizeof(marker_bytes));
+    auto it = std::search(buffer_.begin(), buffer_.end(), marker_bytes, marker_bytes + sizeof(marker_bytes));
+    topic_seq_offset_ = size_t(it - buffer_.begin());
+    reply_id_ = dds::xrce::DATA;
+    return buffer_.end() != it;
+}
+
+inline bool IngestMessage::build_heartbeat(
+        const uxrSession& session)
+{
+    dds::xrce::HEARTBEAT_Payload payload;
+    payload.first_unacked_seq_nr() = uint16_t(1);
+    payload.last_unacked_seq_nr() = uint16_t(0);
+    payload.stream_id() = reliable_stream_id;
+    build(get_header(session, none_stream_id), dds::xrce::HEARTBEAT, payload);
+
+    topic_seq_offset_ = 0;
+    reply_id_ = dds::xrce::ACKNACK;
+    return !buffer_.empty();
+}
+
+inline const std::vector<uint8_t>& IngestMessage::next(
+        uint16_t stream_seq)
+{
+    /* The sequence number of a message header follows its session and stream ids, in little endian. */
+    buffer_[2] = uint8_t(stream_seq & 0xFF);
+    buffer_[3] = uint8_t(stream_seq >> 8);
+    if (0 != topic_seq_offset_)
+    {
+        memcpy(&buffer_[topic_seq_offset_], &topic_seq_, sizeof(topic_seq_));
+        ++topic_seq_;
+    }
+    return buffer_;
+}
+
+/*************************************************************************************************
+ * Ingest Generator
+ *
+ * Sends a message through the communication of a client session, bypassing the session itself,
+ * as fast as possible or at the given rate, while a thread counts the replies of the agent.
+ *************************************************************************************************/
+class IngestGenerator
+{
+public:
+    /*
+     * The stream sequence numbers start well beyond those of the few messages the session sent to
+     * create its entities, and keep growing across runs, so that the best-effort stream of the
+     * agent never discards a message as already received.
+     */
+    IngestGenerator(
+            uxrCommunication* comm,
+            PacerStrategy pacer)
+        : comm_{comm}
+        , pacer_{pacer}
+        , stream_seq_{0x0100}
+        , running_{false}
+        , replies_{0}
+    {}
+
+    /*
+     * Sends the message during duration, at rate msg/s or unpaced if null.
+     */
+    IngestResult run(
+            IngestMessage& message,
+            std::chrono::nanoseconds duration,
+            uint64_t rate);
+
+private:
+    void count_replies(
+            uint8_t reply_id,
+            ResourceUsage& usage);
+
+private:
+    uxrCommunication* comm_;
+    RatePacer pacer_;
+    uint16_t stream_seq_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> replies_;
+};
+
+inline void IngestGenerator::count_replies(
+        uint8_t reply_id,
+        ResourceUsage& usage)
+{
+    ResourceUsage usage_begin = {};
+    (void) read_thread_usage(usage_begin);
+
+    while (running_.load(std::memory_order_relaxed))
+    {
+        uint8_t* buf = nullptr;
+        size_t len = 0;
+        if (!comm_->recv_msg(comm_->instance, &buf, &len, 10) || (4 > len))
+        {
+            continue;
+        }
+
+        /* Submessages start 4-byte aligned after the header, which has a client key below 0x80. */
+        size_t offset = (0x80 > buf[0]) ? 8 : 4;
+        while (offset + 4 <= len)
+        {
+            size_t length = size_t(buf[offset + 2] | (buf[offset + 3] << 8));
+            replies_.fetch_add((reply_id == buf[offset]) ? 1 : 0, std::memory_order_relaxed);
+            offset += (4 + length + 3) & ~size_t(3);
+        }
+    }
+
+    ResourceUsage usage_end = {};
+    (void) read_thread_usage(usage_end);
+    usage = usage_delta(usage_end, usage_begin);
+}
+
+inline IngestResult IngestGenerator::run(
+        IngestMessage& message,
+        std::chrono::nanoseconds duration,
+        uint64_t rate)
+{
+    IngestResult result = {};
+    ResourceUsage sender_begin = {};
+    ResourceUsage receiver_usage = {};
+    (void) read_thread_usage(sender_begin);
+
+    running_ = true;
+    replies_ = 0;
+    std::thread receiver(&IngestGenerator::count_replies, this, message.get_reply_id(), std::ref(receiver_usage));
+
+    pacer_.start(8 * rate * message.size(), message.size());
+    RatePacer::Clock::time_point start = RatePacer::Clock::now();
+    RatePacer::Clock::time_point end = start + duration;
+    while (RatePacer::Clock::now() < end)
+    {
+        if (0 != rate)
+        {
+            pacer_.wait();
+        }
+        const std::vector<uint8_t>& buffer = message.next(stream_seq_++);
+        if (comm_->send_msg(comm_->instance, buffer.data(), buffer.size()))
+        {
+            ++result.sent;
+        }
+        else
+        {
+            ++result.send_errors;
+        }
+    }
+    result.elapsed = RatePacer::Clock::now() - start;
+
+    /* Replies in flight are still counted for a while. */
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    running_ = false;
+    receiver.join();
+    result.replies = replies_;
+
+    ResourceUsage sender_end = {};
+    (void) read_thread_usage(sender_end);
+    result.usage = usage_delta(sender_end, sender_begin);
+    result.usage.user_time += receiver_usage.user_time;
+    result.usage.system_time += receiver_usage.system_time;
+    result.usage.voluntary_switches += receiver_usage.voluntary_switches;
+    result.usage.involuntary_switches += receiver_usage.involuntary_switches;
+    result.usage.syscalls += receiver_usage.syscalls;
+    return result;
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEINGEST_HPP
@@ -0,0 +1,183 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEMONITOR_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEMONITOR_HPP
+
+#include <uxr/client/core/communication/communication.h>
+
+#include <chrono>
+#include <cstdint>
+
+/* XRCE submessage identifiers, as defined by the DDS-XRCE specification. */
+constexpr uint8_t XRCE_ACKNACK_ID = 10;
+constexpr uint8_t XRCE_HEARTBEAT_ID = 11;
+constexpr uint8_t XRCE_FRAGMENT_ID = 13;
+
+/* First stream id of the reliable streams, and session ids from which the client key is omitted. */
+constexpr uint8_t XRCE_RELIABLE_STREAM_ID = 0x80;
+constexpr uint8_t XRCE_SESSION_ID_WITHOUT_CLIENT_KEY = 0x80;
+
+struct StreamStats
+{
+    uint64_t heartbeats_sent;
+    uint64_t heartbeats_received;
+    uint64_t acknacks_sent;
+    uint64_t acknacks_received;
+    uint64_t retransmissions;
+    uint64_t bytes_sent;
+    uint64_t bytes_received;
+};
+
+/*************************************************************************************************
+ * Stream Monitor
+ *
+ * Communication interposed between a session and its transport, in the way of the Gateway of the
+ * interaction tests, which counts the reliability traffic of the session: HEARTBEAT and ACKNACK
+ * submessages in both directions, and reliable messages sent again with an already sent sequence
+ * number. It also timestamps the first received FRAGMENT of every sample, so that the reader can
+ * tell how long the reassembly of that sample took.
+ *************************************************************************************************/
+class StreamMonitor
+{
+public:
+    StreamMonitor()
+        : user_comm_{nullptr}
+        , communication_{}
+        , stats_{}
+        , last_seq_num_{0}
+        , seq_num_valid_{false}
+        , fragment_begin_{}
+        , fragment_pending_{false}
+    {}
+
+    uxrCommunication* monitorize(
+            uxrCommunication* user_comm)
+    {
+        user_comm_ = user_comm;
+        communication_.instance = this;
+        communication_.send_msg = send_dispatcher;
+        communication_.recv_msg = recv_dispatcher;
+        communication_.comm_error = user_comm->comm_error;
+        communication_.mtu = user_comm->mtu;
+
+        return &communication_;
+    }
+
+    void reset_stats() { stats_ = StreamStats{}; }
+    const StreamStats& get_stats() const { return stats_; }
+
+    /*
+     * Reception time of the first fragment of the sample being reassembled, if any. The pending
+     * sample is consumed, so that the next FRAGMENT starts a new one.
+     */
+    bool take_fragment_begin(
+            std::chrono::steady_clock::time_point& begin)
+    {
+        begin = fragment_begin_;
+        bool rv = fragment_pending_;
+        fragment_pending_ = false;
+        return rv;
+    }
+
+private:
+    static bool send_dispatcher(
+            void* instance,
+            const uint8_t* buf,
+            size_t len)
+    {
+        return static_cast<StreamMonitor*>(instance)->send(buf, len);
+    }
+
+    static bool recv_dispatcher(
+            void* instance,
+            uint8_t** buf,
+            size_t* len,
+            int timeout)
+    {
+        return static_cast<StreamMonitor*>(instance)->recv(buf, len, timeout);
+    }
+
+    bool send(
+            const uint8_t* buf,
+            size_t len)
+    {
+        inspect(buf, len, true);
+        return user_comm_->send_msg(user_comm_->instance, buf, len);
+    }
+
+    bool recv(
+            uint8_t** buf,
+            size_t* len,
+            int timeout)
+    {
+        bool rv = user_comm_->recv_msg(user_comm_->instance, buf, len, timeout);
+        if (rv)
+        {
+            inspect(*buf, *len, false);
+        }
+        return rv;
+    }
+
+    /*
+     * Message header: session id, stream id, little endian sequence number and, for the session
+     * ids below 0x80, the client key. Submessages follow, each one aligned to 4 bytes.
+     */
+    void inspect(
+            const uint8_t* buf,
+            size_t len,
+            bool output)
+    {
+        if (4 > len)
+        {
+            return;
+        }
+
+        (output ? stats_.bytes_sent : stats_.bytes_received) += len;
+
+        uint8_t stream_id = buf[1];
+        uint16_t seq_num = uint16_t(buf[2] | (buf[3] << 8));
+        if (output && (XRCE_RELIABLE_STREAM_ID <= stream_id))
+        {
+            if (seq_num_valid_ && (0 >= int16_t(uint16_t(seq_num - last_seq_num_))))
+            {
+                ++stats_.retransmissions;
+            }
+            else
+            {
+                last_seq_num_ = seq_num;
+                seq_num_valid_ = true;
+            }
+        }
+
+        size_t offset = (XRCE_SESSION_ID_WITHOUT_CLIENT_KEY > buf[0]) ? 8 : 4;
+        while (offset + 4 <= len)
+        {
+            uint8_t submessage_id = buf[offset];
+            size_t submessage_length = size_t(buf[offset + 2] | (buf[offset + 3] << 8));
+            if (XRCE_HEARTBEAT_ID == submessage_id)
+            {
+                ++(output ? stats_.heartbeats_sent : stats_.heartbeats_received);
+            }
+            else if (XRCE_ACKNACK_ID == submessage_id)
+            {
+                ++(output ? stats_.acknacks_sent : stats_.acknacks_received);
+            }
+            else if ((XRCE_FRAGMENT_ID == submessage_id) && !output && !fragment_pending_)
+            {
+                fragment_begin_ = std::chrono::steady_clock::now();
+                fragment_pending_ = true;
+            }
+            offset += 4 + submessage_length;
+            offset = (offset + 3) & ~size_t(3);
+        }
+    }
+
+private:
+    uxrCommunication* user_comm_;
+    uxrCommunication communication_;
+    StreamStats stats_;
+    uint16_t last_seq_num_;
+    bool seq_num_valid_;
+    std::chrono::steady_clock::time_point fragment_begin_;
+    bool fragment_pending_;
+};
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEMONITOR_HPP
@@ -0,0 +1,154 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEPACER_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEPACER_HPP
+
+#include "PerformanceHistogram.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+enum class PacerStrategy : uint8_t
+{
+    SLEEP,
+    HYBRID,
+    SPIN
+};
+
+/*************************************************************************************************
+ * Rate Pacer
+ *
+ * Token bucket with nanosecond resolution and a burst of one message: the n-th send is released
+ * at start + n * interval, and a sender which falls behind by more than one interval gives up the
+ * missed tokens instead of catching up with a burst. Every released send records its deviation
+ * from the nominal interval, so the offered load of a run can be checked against the requested.
+ *************************************************************************************************/
+class RatePacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RatePacer(
+            PacerStrategy strategy = PacerStrategy::HYBRID)
+        : strategy_{strategy}
+        , interval_{0}
+        , next_release_{}
+        , last_release_{}
+        , released_{0}
+    {}
+
+    void set_strategy(
+            PacerStrategy strategy)
+    {
+        strategy_ = strategy;
+    }
+
+    /*
+     * Rate in bit/s of messages of msg_size bytes. A null rate disables pacing.
+     */
+    void start(
+            uint64_t throughput,
+            size_t msg_size);
+
+    /*
+     * Blocks until the next token is available.
+     */
+    void wait();
+
+    /*
+     * Blocks until deadline, following the strategy of the pacer.
+     */
+    void wait_until(
+            Clock::time_point deadline);
+
+    /*
+     * Time at which the next call to wait() will return, at the earliest.
+     */
+    Clock::time_point get_next_release() const
+    {
+        return (0 != released_) ? next_release_ + interval_ : next_release_;
+    }
+
+    std::chrono::nanoseconds get_interval() const { return interval_; }
+
+    /* Absolute deviation (ns) of the achieved inter-send intervals from the nominal one. */
+    const LatencyHistogram& get_interval_error() const { return interval_error_; }
+
+private:
+    PacerStrategy strategy_;
+    std::chrono::nanoseconds interval_;
+    Clock::time_point next_release_;
+    Clock::time_point last_release_;
+    uint64_t released_;
+    LatencyHistogram interval_error_;
+};
+
+inline void RatePacer::start(
+        uint64_t throughput,
+        size_t msg_size)
+{
+    interval_ = (0 == throughput)
+            ? std::chrono::nanoseconds(0)
+            : std::chrono::nanoseconds(std::chrono::nanoseconds::rep(
+                double(8 * msg_size) * double(std::nano::den) / double(throughput)));
+    next_release_ = Clock::now();
+    last_release_ = next_release_;
+    released_ = 0;
+    interval_error_.reset();
+}
+
+inline void RatePacer::wait()
+{
+    if (0 != released_)
+    {
+        next_release_ += interval_;
+        wait_until(next_release_);
+    }
+
+    Clock::time_point now = Clock::now();
+    if (now - next_release_ > interval_)
+    {
+        /* Behind schedule: drop the missed tokens rather than bursting to catch up. */
+        next_release_ = now;
+    }
+
+    if (0 != released_)
+    {
+        std::chrono::nanoseconds::rep error = (now - last_release_ - interval_).count();
+        interval_error_.record(uint64_t((0 > error) ? -error : error));
+    }
+    last_release_ = now;
+    ++released_;
+}
+
+inline void RatePacer::wait_until(
+        Clock::time_point deadline)
+{
+    switch (strategy_)
+    {
+        case PacerStrategy::SLEEP:
+        {
+            std::this_thread::sleep_until(deadline);
+            break;
+        }
+        case PacerStrategy::HYBRID:
+        {
+            /* Sleeps are only trusted up to the last 100 us, the remainder is spun. */
+            Clock::time_point sleep_deadline = deadline - std::chrono::microseconds(100);
+            if (Clock::now() < sleep_deadline)
+            {
+                std::this_thread::sleep_until(sleep_deadline);
+            }
+            while (Clock::now() < deadline)
+            {}
+            break;
+        }
+        case PacerStrategy::SPIN:
+        {
+            while (Clock::now() < deadline)
+            {}
+            break;
+        }
+    }
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEPACER_HPP
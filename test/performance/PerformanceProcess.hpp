@@ -0,0 +1,348 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEPROCESS_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEPROCESS_HPP
+
+#include "PerformanceHistogram.hpp"
+#include "PerformanceMonitor.hpp"
+#include "PerformanceSequence.hpp"
+#include "PerformanceSystem.hpp"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <new>
+#include <string>
+#include <thread>
+
+#if defined(PLATFORM_NAME_LINUX)
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // PLATFORM_NAME_LINUX
+
+/*
+ * Process a test runs in: both clients as threads of a single process, or one client per process
+ * driven by a coordinator process.
+ */
+enum class ProcessRole : uint8_t
+{
+    THREADS,
+    PUBLISHER,
+    SUBSCRIBER,
+    COORDINATOR
+};
+
+/*
+ * Outcome of a throughput run on each side. Both are plain data, so that the roles of a
+ * multi-process test can hand them over to the coordinator through shared memory.
+ */
+struct PublisherRunResult
+{
+    uint64_t throughput;
+    uint64_t msg_count;
+    std::chrono::nanoseconds pacing_interval;
+    double pacing_err_avg;
+    uint64_t pacing_err_p99;
+    std::chrono::nanoseconds blocked_time;
+    std::chrono::nanoseconds cpu_time;
+    ResourceUsage usage;
+    StreamStats stream;
+};
+
+struct SubscriberRunResult
+{
+    uint64_t throughput;
+    uint64_t msg_count;
+    double latency_avg;
+    double latency_std;
+    LatencyHistogram histogram;
+    SequenceStats sequence;
+    WindowLoss window_loss;
+    std::chrono::nanoseconds cpu_time;
+    ResourceUsage usage;
+    StreamStats stream;
+};
+
+#if defined(PLATFORM_NAME_LINUX)
+
+/*
+ * Run the coordinator requests from both roles. A stop command ends the roles.
+ */
+struct SharedCommand
+{
+    uint64_t size;
+    uint64_t throughput;
+    std::chrono::nanoseconds duration;
+    bool stop;
+};
+
+struct SharedRoleState
+{
+    std::atomic<uint32_t> attached;
+    std::atomic<uint32_t> done;
+};
+
+/*
+ * Layout of the shared-memory segment. The coordinator publishes a command by incrementing
+ * command_seq, and every role acknowledges it by setting its done to the same value once its
+ * result is written. The publisher reports the limits of its stream when it attaches.
+ */
+struct SharedSegment
+{
+    static constexpr uint32_t ready_magic = 0x55585243;
+
+    std::atomic<uint32_t> magic;
+    pid_t coordinator_pid;
+    std::atomic<uint32_t> command_seq;
+    SharedCommand command;
+    size_t max_payload;
+    size_t mtu;
+    uint16_t history;
+    SharedRoleState publisher_state;
+    SharedRoleState subscriber_state;
+    PublisherRunResult publisher;
+    SubscriberRunResult subscriber;
+};
+
+/*************************************************************************************************
+ * Shared Channel
+ *
+ * POSIX shared-memory segment between the coordinator and the publisher and subscriber roles of
+ * a multi-process test. The coordinator creates it, replacing any segment left by a previous run,
+ * and the roles attach to it once it is ready. Waits poll the segment, which is only done between
+ * runs, hence the polling period is kept short but not busy.
+ *************************************************************************************************/
+class SharedChannel
+{
+public:
+    static constexpr std::chrono::microseconds poll_period{100};
+
+    SharedChannel()
+        : segment_{nullptr}
+        , name_{}
+        , owner_{false}
+        , role_{ProcessRole::COORDINATOR}
+        , last_command_{0}
+    {}
+
+    ~SharedChannel()
+    {
+        if (nullptr != segment_)
+        {
+            (void) munmap(segment_, sizeof(SharedSegment));
+        }
+        if (owner_)
+        {
+            (void) shm_unlink(name_.c_str());
+        }
+    }
+
+    SharedSegment& get() { return *segment_; }
+
+    bool create(
+            const std::string& name);
+
+    bool attach(
+            const std::string& name,
+            ProcessRole role,
+            std::chrono::seconds timeout);
+
+    /*
+     * Coordinator side: waits for both roles, then runs a command on them until both complete it
+     * or the timeout expires.
+     */
+    bool wait_attached(
+            std::chrono::seconds timeout);
+
+    bool run(
+            const SharedCommand& command,
+            std::chrono::nanoseconds timeout);
+
+    void stop();
+
+    /*
+     * Role side: announces the role once it is ready, then waits for the next command, which is
+     * false on a stop command or if the coordinator exited.
+     */
+    void announce();
+
+    bool wait_command(
+            SharedCommand& command);
+
+    void complete();
+
+private:
+    bool map(
+            int fd);
+
+    bool is_coordinator_alive() const
+    {
+        return (0 == kill(segment_->coordinator_pid, 0)) || (EPERM == errno);
+    }
+
+    SharedRoleState& role_state()
+    {
+        return (ProcessRole::PUBLISHER == role_) ? segment_->publisher_state : segment_->subscriber_state;
+    }
+
+private:
+    SharedSegment* segment_;
+    std::string name_;
+    bool owner_;
+    ProcessRole role_;
+    uint32_t last_command_;
+};
+
+constexpr std::chrono::microseconds SharedChannel::poll_period;
+
+inline bool SharedChannel::map(
+        int fd)
+{
+    void* address = mmap(nullptr, sizeof(SharedSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    (void) close(fd);
+    if (MAP_FAILED == address)
+    {
+        return false;
+    }
+    segment_ = static_cast<SharedSegment*>(address);
+    return true;
+}
+
+inline bool SharedChannel::create(
+        const std::string& name)
+{
+    (void) shm_unlink(name.c_str());
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if ((-1 == fd) || (0 != ftruncate(fd, off_t(sizeof(SharedSegment)))))
+    {
+        if (-1 != fd)
+        {
+            (void) close(fd);
+            (void) shm_unlink(name.c_str());
+        }
+        return false;
+    }
+    name_ = name;
+    owner_ = true;
+    if (!map(fd))
+    {
+        return false;
+    }
+
+    new (segment_) SharedSegment{};
+    segment_->coordinator_pid = getpid();
+    segment_->magic.store(SharedSegment::ready_magic, std::memory_order_release);
+    return true;
+}
+
+inline bool SharedChannel::attach(
+        const std::string& name,
+        ProcessRole role,
+        std::chrono::seconds timeout)
+{
+    role_ = role;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        int fd = shm_open(name.c_str(), O_RDWR, 0);
+        struct stat info = {};
+        if ((-1 != fd) && (0 == fstat(fd, &info)) && (off_t(sizeof(SharedSegment)) == info.st_size) && map(fd))
+        {
+            /* A segment left by a coordinator which exited is waited to be replaced. */
+            if ((SharedSegment::ready_magic == segment_->magic.load(std::memory_order_acquire))
+                && is_coordinator_alive())
+            {
+                last_command_ = segment_->command_seq.load(std::memory_order_acquire);
+                return true;
+            }
+            (void) munmap(segment_, sizeof(SharedSegment));
+            segment_ = nullptr;
+        }
+        else if (-1 != fd)
+        {
+            (void) close(fd);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    return false;
+}
+
+inline bool SharedChannel::wait_attached(
+        std::chrono::seconds timeout)
+{
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    while ((0 == segment_->publisher_state.attached.load(std::memory_order_acquire))
+        || (0 == segment_->subscriber_state.attached.load(std::memory_order_acquire)))
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(poll_period);
+    }
+    return true;
+}
+
+inline bool SharedChannel::run(
+        const SharedCommand& command,
+        std::chrono::nanoseconds timeout)
+{
+    segment_->command = command;
+    uint32_t seq = segment_->command_seq.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now() + timeout;
+    while ((seq != segment_->publisher_state.done.load(std::memory_order_acquire))
+        || (seq != segment_->subscriber_state.done.load(std::memory_order_acquire)))
+    {
+        if (std::chrono::steady_clock::now() >= deadline)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(poll_period);
+    }
+    return true;
+}
+
+inline void SharedChannel::stop()
+{
+    SharedCommand command = {};
+    command.stop = true;
+    segment_->command = command;
+    (void) segment_->command_seq.fetch_add(1, std::memory_order_acq_rel);
+}
+
+inline void SharedChannel::announce()
+{
+    role_state().attached.store(1, std::memory_order_release);
+}
+
+inline bool SharedChannel::wait_command(
+        SharedCommand& command)
+{
+    uint32_t seq = segment_->command_seq.load(std::memory_order_acquire);
+    while (seq == last_command_)
+    {
+        if (!is_coordinator_alive())
+        {
+            std::cerr << "The coordinator exited" << std::endl;
+            return false;
+        }
+        std::this_thread::sleep_for(poll_period);
+        seq = segment_->command_seq.load(std::memory_order_acquire);
+    }
+    last_command_ = seq;
+    command = segment_->command;
+    return !command.stop;
+}
+
+inline void SharedChannel::complete()
+{
+    role_state().done.store(last_command_, std::memory_order_release);
+}
+
+#endif // PLATFORM_NAME_LINUX
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEPROCESS_HPP
@@ -2,6 +2,8 @@
 #define IN_TEST_PERFORMANCE_PERFORMANCEPUBLISHER_HPP
 
 #include "PerformanceClient.hpp"
+#include "PerformanceHistogram.hpp"
+#include "PerformancePacer.hpp"
 #include "PerformanceTopic.hpp"
 #include <EntitiesInfo.hpp>
 
@@ -11,25 +13,120 @@ template<MiddlewareKind MK>
 class PerformancePublisher : public PerformanceClient
 {
 public:
-    PerformancePublisher() {}
+    /*
+     * A ping-pong publisher additionally subscribes to the echo topic, so that ping() can measure
+     * the round-trip time of every sample with its own clock.
+     */
+    explicit PerformancePublisher(
+            bool pingpong = false,
+            PacerStrategy pacer_strategy = PacerStrategy::HYBRID)
+        : pingpong_{pingpong}
+        , pacer_{pacer_strategy}
+        , blocked_time_{0}
+        , batch_size_{1}
+        , batch_deadline_{0}
+        , batch_pending_{0}
+        , batch_begin_{}
+        , batch_sample_sum_{0}
+        , batch_wait_{0}
+        , flush_count_{0}
+        , write_path_{WritePath::TOPIC}
+        , staging_{}
+        , write_time_{0}
+    {}
 
     ~PerformancePublisher() override = default;
 
-    template<size_t Size, typename D>
+    template<typename D>
     void publish(
+            size_t size,
             D duration,
             uint64_t throughput);
 
+    template<typename D>
+    void ping(
+            size_t size,
+            D duration);
+
     uint64_t get_msg_count() { return msg_count_; }
+    uint64_t get_lost_count() { return lost_count_; }
     uint64_t get_throughput() { return throughput_; }
+    const LatencyHistogram& get_rtt_histogram() const { return rtt_histogram_; }
+    const RatePacer& get_pacer() const { return pacer_; }
+    uxrObjectId get_datawriter_id() const { return uxr_object_id(entities_prefix_, UXR_DATAWRITER_ID); }
+
+    /*
+     * Time the last publication spent waiting for room in the history of the reliable stream.
+     */
+    std::chrono::nanoseconds get_blocked_time() const { return blocked_time_; }
+
+    /*
+     * Samples written to the output stream before it is flushed, in a single message as long as
+     * they fit in it. With a deadline, a batch is also flushed once its first sample has waited
+     * that long. Set before publish().
+     */
+    void set_batching(
+            size_t samples,
+            std::chrono::nanoseconds deadline)
+    {
+        batch_size_ = (0 < samples) ? samples : 1;
+        batch_deadline_ = deadline;
+    }
+
+    uint64_t get_flush_count() const { return flush_count_; }
+
+    /*
+     * Way the samples are written to the output stream. Set before publish().
+     */
+    void set_write_path(
+            WritePath path)
+    {
+        write_path_ = path;
+    }
+
+    /*
+     * Average time the samples of the last publication took to be written once their room in the
+     * output stream was prepared, which is all their payload copies cost.
+     */
+    std::chrono::nanoseconds get_write_time_avg() const
+    {
+        return (0 != msg_count_) ? write_time_ / int64_t(msg_count_) : std::chrono::nanoseconds{0};
+    }
+
+    /*
+     * Average time the samples of the last publication waited in the stream before their flush.
+     */
+    std::chrono::nanoseconds get_batch_wait_avg() const
+    {
+        return (0 != msg_count_) ? batch_wait_ / int64_t(msg_count_) : std::chrono::nanoseconds{0};
+    }
 
 private:
     bool create_entities() final;
 
-    template<size_t Size>
-    std::chrono::milliseconds sleep_time(
-            std::chrono::milliseconds elapsed_time,
-            uint64_t throughput);
+    static void echo_callback_dispatcher(
+            uxrSession* session,
+            uxrObjectId object_id,
+            uint16_t request_id,
+            uxrStreamId stream_id,
+            ucdrBuffer* serialization,
+            void* args);
+
+    void echo_callback(
+            uxrSession* session,
+            uxrObjectId object_id,
+            uint16_t request_id,
+            uxrStreamId stream_id,
+            ucdrBuffer* serialization);
+
+    void flush_batch();
+
+    void prepare_write(
+            const PerformanceTopic& topic);
+
+    bool write_sample(
+            ucdrBuffer& ub,
+            const PerformanceTopic& topic);
 
     template<typename D>
     void fini_publication(
@@ -38,47 +135,215 @@ private:
 
 private:
     static uint16_t entities_prefix_;
+    static uint16_t echo_entities_prefix_;
+    bool pingpong_;
+    size_t msg_size_;
     uint64_t msg_count_;
+    uint64_t lost_count_;
     uint64_t throughput_;
+    uint64_t ping_timestamp_;
+    bool pong_received_;
+    LatencyHistogram rtt_histogram_;
+    RatePacer pacer_;
+    std::chrono::nanoseconds blocked_time_;
+    size_t batch_size_;
+    std::chrono::nanoseconds batch_deadline_;
+    size_t batch_pending_;
+    RatePacer::Clock::time_point batch_begin_;
+    std::chrono::nanoseconds batch_sample_sum_;
+    std::chrono::nanoseconds batch_wait_;
+    uint64_t flush_count_;
+    WritePath write_path_;
+    PerformanceArena staging_;
+    std::chrono::nanoseconds write_time_;
 };
 
 template<MiddlewareKind MK>
-template<size_t Size, typename D>
+template<typename D>
 inline void PerformancePublisher<MK>::publish(
+        size_t size,
         D duration,
         uint64_t throughput)
 {
-    uxrStreamId output_stream_id = uxr_stream_id_from_raw(0x01, UXR_OUTPUT_STREAM);
+    uxrStreamId output_stream_id = uxr_stream_id_from_raw(get_data_stream_raw(), UXR_OUTPUT_STREAM);
     uxrObjectId datawriter_id = uxr_object_id(entities_prefix_, UXR_DATAWRITER_ID);
 
     std::chrono::milliseconds duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
     std::chrono::milliseconds elapsed_time{};
     std::chrono::time_point<std::chrono::high_resolution_clock> init_time;
     std::chrono::time_point<std::chrono::high_resolution_clock> current_time;
+    std::chrono::time_point<std::chrono::high_resolution_clock> blocked_time;
 
     ucdrBuffer ub;
-    PerformanceTopic<Size> topic = {0};
+    PerformanceTopic topic = {};
+    arena_.reserve(size);
+    topic.data = arena_.data();
+    topic.size = size;
+    msg_size_ = size;
+    prepare_write(topic);
 
+    begin_usage();
     init_time = std::chrono::high_resolution_clock::now();
     msg_count_ = 0;
+    blocked_time_ = std::chrono::nanoseconds{0};
+    batch_pending_ = 0;
+    batch_sample_sum_ = std::chrono::nanoseconds{0};
+    batch_wait_ = std::chrono::nanoseconds{0};
+    flush_count_ = 0;
+    write_time_ = std::chrono::nanoseconds{0};
+    monitor_.reset_stats();
+    pacer_.start(throughput, size);
     while (elapsed_time < duration_ms)
     {
+        if ((0 != batch_pending_) && (0 < batch_deadline_.count())
+            && (batch_begin_ + batch_deadline_ < pacer_.get_next_release()))
+        {
+            pacer_.wait_until(batch_begin_ + batch_deadline_);
+            flush_batch();
+        }
+
+        pacer_.wait();
+
         std::chrono::nanoseconds epoch_time = std::chrono::high_resolution_clock::now().time_since_epoch();
         topic.timestamp[0] = epoch_time.count() >> 32;
         topic.timestamp[1] = epoch_time.count() & UINT32_MAX;
+        topic.seq_num = uint32_t(msg_count_);
 
-        if (uxr_prepare_output_stream(&session_, output_stream_id, datawriter_id, &ub, Size) && topic.serialize(ub))
+        bool prepared = uxr_prepare_output_stream(&session_, output_stream_id, datawriter_id, &ub, uint32_t(size));
+        if (!prepared && (0 != batch_pending_))
+        {
+            /* No room left in the stream for another sample of the batch. */
+            flush_batch();
+            prepared = uxr_prepare_output_stream(&session_, output_stream_id, datawriter_id, &ub, uint32_t(size));
+        }
+        if (!prepared && is_reliable())
+        {
+            /* Full window: the session is run until an ACKNACK releases a slot of the history. */
+            blocked_time = std::chrono::high_resolution_clock::now();
+            do
+            {
+                uxr_run_session_until_timeout(&session_, 1);
+                prepared = uxr_prepare_output_stream(&session_, output_stream_id, datawriter_id, &ub, uint32_t(size));
+                current_time = std::chrono::high_resolution_clock::now();
+            }
+            while (!prepared && (current_time - init_time < duration_ms));
+            blocked_time_ += current_time - blocked_time;
+        }
+
+        RatePacer::Clock::time_point write_begin = RatePacer::Clock::now();
+        if (prepared && write_sample(ub, topic))
+        {
+            ++msg_count_;
+            RatePacer::Clock::time_point sample_time = RatePacer::Clock::now();
+            write_time_ += sample_time - write_begin;
+            if (0 == batch_pending_)
+            {
+                batch_begin_ = sample_time;
+            }
+            ++batch_pending_;
+            batch_sample_sum_ += sample_time - batch_begin_;
+            if (batch_pending_ >= batch_size_)
+            {
+                flush_batch();
+            }
+        }
+
+        if (is_reliable())
+        {
+            uxr_run_session_until_timeout(&session_, 0);
+        }
+
+        current_time = std::chrono::high_resolution_clock::now();
+        elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - init_time);
+    }
+
+    if (0 != batch_pending_)
+    {
+        flush_batch();
+    }
+
+    end_usage();
+    fini_publication(current_time - init_time, size);
+
+    /* The next run starts with an empty window. */
+    if (is_reliable())
+    {
+        (void) uxr_run_session_until_confirm_delivery(&session_, 1000);
+    }
+}
+
+template<MiddlewareKind MK>
+template<typename D>
+inline void PerformancePublisher<MK>::ping(
+        size_t size,
+        D duration)
+{
+    const std::chrono::milliseconds pong_timeout{1000};
+
+    uxrStreamId output_stream_id = uxr_stream_id_from_raw(get_data_stream_raw(), UXR_OUTPUT_STREAM);
+    uxrStreamId request_stream_id = uxr_stream_id(0, UXR_RELIABLE_STREAM, UXR_OUTPUT_STREAM);
+    uxrStreamId input_stream_id = uxr_stream_id_from_raw(get_data_stream_raw(), UXR_INPUT_STREAM);
+    uxrObjectId datawriter_id = uxr_object_id(entities_prefix_, UXR_DATAWRITER_ID);
+    uxrObjectId datareader_id = uxr_object_id(echo_entities_prefix_, UXR_DATAREADER_ID);
+
+    uxr_set_topic_callback(&session_, echo_callback_dispatcher, this);
+
+    uxrDeliveryControl delivery_control = {};
+    delivery_control.max_samples = UXR_MAX_SAMPLES_UNLIMITED;
+    uxr_buffer_request_data(&session_, request_stream_id, datareader_id, input_stream_id, &delivery_control);
+
+    std::chrono::milliseconds duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(duration);
+    std::chrono::milliseconds elapsed_time{};
+    std::chrono::time_point<std::chrono::high_resolution_clock> init_time;
+    std::chrono::time_point<std::chrono::high_resolution_clock> ping_time;
+    std::chrono::time_point<std::chrono::high_resolution_clock> current_time;
+
+    ucdrBuffer ub;
+    PerformanceTopic topic = {};
+    arena_.reserve(size);
+    topic.data = arena_.data();
+    topic.size = size;
+    msg_size_ = size;
+
+    rtt_histogram_.reset();
+    msg_count_ = 0;
+    lost_count_ = 0;
+    monitor_.reset_stats();
+    init_time = std::chrono::high_resolution_clock::now();
+    while (elapsed_time < duration_ms)
+    {
+        ping_time = std::chrono::high_resolution_clock::now();
+        std::chrono::nanoseconds epoch_time = ping_time.time_since_epoch();
+        topic.timestamp[0] = epoch_time.count() >> 32;
+        topic.timestamp[1] = epoch_time.count() & UINT32_MAX;
+        topic.seq_num = uint32_t(msg_count_);
+        ping_timestamp_ = uint64_t(epoch_time.count());
+        pong_received_ = false;
+
+        if (uxr_prepare_output_stream(&session_, output_stream_id, datawriter_id, &ub, uint32_t(size)) && topic.serialize(ub))
         {
             (void) uxr_flash_output_streams(&session_);
             ++msg_count_;
-            std::this_thread::sleep_for(sleep_time<Size>(elapsed_time, throughput));
+
+            /* Only one ping in flight, so that the RTT does not include queuing behind previous pings. */
+            do
+            {
+                uxr_run_session_until_timeout(&session_, 0);
+                current_time = std::chrono::high_resolution_clock::now();
+            }
+            while (!pong_received_ && (current_time - ping_time < pong_timeout));
+
+            if (!pong_received_)
+            {
+                ++lost_count_;
+            }
         }
 
         current_time = std::chrono::high_resolution_clock::now();
-        elapsed_time = std::chrono::duration_cast<D>(current_time - init_time);
+        elapsed_time = std::chrono::duration_cast<std::chrono::milliseconds>(current_time - init_time);
     }
 
-    fini_publication(elapsed_time, Size);
+    fini_publication(current_time - init_time, size);
 }
 
 template<MiddlewareKind MK>
@@ -88,22 +353,21 @@ inline bool PerformancePublisher<MK>::create_entities()
 
     uint8_t flags = 0x00;
     uxrStreamId output_stream_id = uxr_stream_id_from_raw(0x01, UXR_OUTPUT_STREAM);
-    uint16_t request_id; uint8_t status;
+    uint16_t request_id;
 
     uxrObjectId participant_id = uxr_object_id(entities_prefix_, UXR_PARTICIPANT_ID);
     request_id = uxr_buffer_create_participant_xml(
         &session_, output_stream_id, participant_id, 11, EInfo::participant_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != participant_id) || (last_request_id_ != request_id))
+    if (!wait_status(participant_id, request_id))
     {
         return false;
     }
 
     uxrObjectId topic_id = uxr_object_id(entities_prefix_, UXR_TOPIC_ID);
     request_id = uxr_buffer_create_topic_xml(
-        &session_, output_stream_id, topic_id, participant_id, EInfo::topic_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != topic_id) || (last_request_id_ != request_id))
+        &session_, output_stream_id, topic_id, participant_id,
+        with_topic_suffix(EInfo::topic_xml, EInfo::topic_name).c_str(), flags);
+    if (!wait_status(topic_id, request_id))
     {
         return false;
     }
@@ -111,35 +375,169 @@ inline bool PerformancePublisher<MK>::create_entities()
     uxrObjectId publisher_id = uxr_object_id(entities_prefix_, UXR_PUBLISHER_ID);
     request_id = uxr_buffer_create_publisher_xml(
         &session_, output_stream_id, publisher_id, participant_id, EInfo::publisher_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != publisher_id) || (last_request_id_ != request_id))
+    if (!wait_status(publisher_id, request_id))
     {
         return false;
     }
 
     uxrObjectId datawriter_id = uxr_object_id(entities_prefix_, UXR_DATAWRITER_ID);
     request_id = uxr_buffer_create_datawriter_xml(
-        &session_, output_stream_id, datawriter_id, publisher_id, EInfo::datawriter_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != datawriter_id) || (last_request_id_ != request_id))
+        &session_, output_stream_id, datawriter_id, publisher_id,
+        with_topic_suffix(EInfo::datawriter_xml, EInfo::topic_name).c_str(), flags);
+    if (!wait_status(datawriter_id, request_id))
     {
         return false;
     }
 
+    if (pingpong_)
+    {
+        uxrObjectId echo_topic_id = uxr_object_id(echo_entities_prefix_, UXR_TOPIC_ID);
+        request_id = uxr_buffer_create_topic_xml(
+            &session_, output_stream_id, echo_topic_id, participant_id,
+            with_topic_suffix(EInfo::echo_topic_xml, EInfo::echo_topic_name).c_str(), flags);
+        if (!wait_status(echo_topic_id, request_id))
+        {
+            return false;
+        }
+
+        uxrObjectId subscriber_id = uxr_object_id(echo_entities_prefix_, UXR_SUBSCRIBER_ID);
+        request_id = uxr_buffer_create_subscriber_xml(
+            &session_, output_stream_id, subscriber_id, participant_id, EInfo::subscriber_xml, flags);
+        if (!wait_status(subscriber_id, request_id))
+        {
+            return false;
+        }
+
+        uxrObjectId datareader_id = uxr_object_id(echo_entities_prefix_, UXR_DATAREADER_ID);
+        request_id = uxr_buffer_create_datareader_xml(
+            &session_, output_stream_id, datareader_id, subscriber_id,
+            with_topic_suffix(EInfo::echo_datareader_xml, EInfo::echo_topic_name).c_str(), flags);
+        if (!wait_status(datareader_id, request_id))
+        {
+            return false;
+        }
+    }
+
     return true;
 }
 
 template<MiddlewareKind MK>
-template<size_t Size>
-inline std::chrono::milliseconds PerformancePublisher<MK>::sleep_time(
-        std::chrono::milliseconds elapsed_time,
-        uint64_t throughput)
+inline void PerformancePublisher<MK>::echo_callback_dispatcher(
+        uxrSession* session,
+        uxrObjectId object_id,
+        uint16_t request_id,
+        uxrStreamId stream_id,
+        ucdrBuffer* serialization,
+        void* args)
+{
+    static_cast<PerformancePublisher*>(args)->echo_callback(session, object_id, request_id, stream_id, serialization);
+}
+
+template<MiddlewareKind MK>
+inline void PerformancePublisher<MK>::echo_callback(
+        uxrSession* session,
+        uxrObjectId object_id,
+        uint16_t request_id,
+        uxrStreamId stream_id,
+        ucdrBuffer* serialization)
+{
+    (void) session;
+    (void) object_id;
+    (void) request_id;
+    (void) stream_id;
+
+    PerformanceTopic topic;
+    topic.data = arena_.data();
+    topic.size = msg_size_;
+    topic.deserialize(*serialization);
+    uint64_t timestamp = (uint64_t(topic.timestamp[0]) << 32) + topic.timestamp[1];
+
+    std::chrono::nanoseconds epoch_time = std::chrono::high_resolution_clock::now().time_since_epoch();
+
+    /* Late pongs of previous pings are discarded, they were already accounted as lost. */
+    if (timestamp == ping_timestamp_)
+    {
+        rtt_histogram_.record(uint64_t(epoch_time.count()) - timestamp);
+        pong_received_ = true;
+
+        if (nullptr != trace_)
+        {
+            trace_->record(trace_run_, uint32_t(msg_size_), timestamp, uint64_t(epoch_time.count()));
+        }
+    }
+}
+
+/*
+ * The samples of a batch are timed relative to its first one, so that the wait of all of them is
+ * accounted at once.
+ */
+template<MiddlewareKind MK>
+inline void PerformancePublisher<MK>::flush_batch()
 {
-    std::chrono::milliseconds expected_time =
-            std::chrono::milliseconds((8 * msg_count_ * Size / throughput) * std::milli::den);
-    return (expected_time.count() > elapsed_time.count())
-            ? (expected_time - elapsed_time)
-            : std::chrono::milliseconds(0);
+    (void) uxr_flash_output_streams(&session_);
+    std::chrono::nanoseconds batch_age = RatePacer::Clock::now() - batch_begin_;
+    batch_wait_ += batch_age * int64_t(batch_pending_) - batch_sample_sum_;
+    ++flush_count_;
+    batch_pending_ = 0;
+    batch_sample_sum_ = std::chrono::nanoseconds{0};
+}
+
+/*
+ * The struct and the blob are staged in a buffer of their own, the blob serialized once here.
+ */
+template<MiddlewareKind MK>
+inline void PerformancePublisher<MK>::prepare_write(
+        const PerformanceTopic& topic)
+{
+    if ((WritePath::STRUCT == write_path_) || (WritePath::BLOB == write_path_))
+    {
+        staging_.reserve(topic.size);
+    }
+    if (WritePath::BLOB == write_path_)
+    {
+        ucdrBuffer ub;
+        ucdr_init_buffer(&ub, staging_.data(), uint32_t(topic.size));
+        (void) topic.serialize(ub);
+    }
+}
+
+template<MiddlewareKind MK>
+inline bool PerformancePublisher<MK>::write_sample(
+        ucdrBuffer& ub,
+        const PerformanceTopic& topic)
+{
+    size_t payload_size = topic.size - PerformanceTopic::header_size;
+    switch (write_path_)
+    {
+        case WritePath::STRUCT:
+        {
+            PerformanceTopic owned = topic;
+            owned.data = staging_.data();
+            std::memcpy(owned.data, topic.data, payload_size);
+            return owned.serialize(ub);
+        }
+        case WritePath::BLOB:
+        {
+            ucdrBuffer header;
+            ucdr_init_buffer(&header, staging_.data(), uint32_t(PerformanceTopic::header_size));
+            (void) topic.serialize_header(header);
+            (void) ucdr_serialize_array_uint8_t(&ub, staging_.data(), uint32_t(topic.size));
+            return !ub.error;
+        }
+        case WritePath::IN_PLACE:
+        {
+            /* The payload would be produced at ub.iterator, the room prepared for it is just taken. */
+            if (!topic.serialize_header(ub))
+            {
+                return false;
+            }
+            ucdr_advance_buffer(&ub, payload_size);
+            return !ub.error;
+        }
+        case WritePath::TOPIC:
+        default:
+            return topic.serialize(ub);
+    }
 }
 
 template<MiddlewareKind MK>
@@ -148,10 +546,14 @@ inline void PerformancePublisher<MK>::fini_publication(
         D real_duration,
         size_t msg_size)
 {
-    throughput_ = std::milli::den * msg_size * 8 * msg_count_ / std::chrono::duration_cast<std::chrono::milliseconds>(real_duration).count();
+    double ns = double(std::chrono::duration_cast<std::chrono::nanoseconds>(real_duration).count());
+    throughput_ = (0.0 < ns) ? uint64_t(double(std::nano::den) * double(msg_size * 8 * msg_count_) / ns) : 0;
 }
 
 template<MiddlewareKind MK>
 uint16_t PerformancePublisher<MK>::entities_prefix_ = 0x0000;
 
+template<MiddlewareKind MK>
+uint16_t PerformancePublisher<MK>::echo_entities_prefix_ = 0x0001;
+
 #endif // IN_TEST_PERFORMANCE_PERFORMANCEPUBLISHER_HPP
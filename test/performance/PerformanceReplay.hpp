@@ -0,0 +1,480 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCEREPLAY_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCEREPLAY_HPP
+
+#include "PerformancePacer.hpp"
+#include "PerformanceSystem.hpp"
+
+#include <TransportInfo.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+enum class ReplaySpeed : uint8_t
+{
+    ORIGINAL,
+    SCALED,
+    FAST
+};
+
+/*
+ * Client to agent frame of a capture, with its capture time relative to the first frame and the
+ * index of the client which sent it.
+ */
+struct ReplayFrame
+{
+    std::chrono::nanoseconds timestamp;
+    size_t client;
+    std::vector<uint8_t> data;
+};
+
+struct ReplayCapture
+{
+    std::vector<ReplayFrame> frames;
+    size_t clients;
+    uint64_t bytes;
+    uint64_t skipped;
+};
+
+struct ReplayResult
+{
+    uint64_t frames;
+    uint64_t bytes;
+    uint64_t send_errors;
+    uint64_t replies;
+    uint64_t reply_bytes;
+    std::chrono::nanoseconds send_time;
+    std::chrono::nanoseconds processing_time;
+    ResourceUsage agent_usage;
+};
+
+/*************************************************************************************************
+ * Capture Reader
+ *
+ * Reads the UDP datagrams sent to the agent port out of a pcap file, in either byte order and
+ * timestamp resolution. Frames written by a Gateway capture (raw IPv4) are read as well as those
+ * captured by tcpdump on an Ethernet or a Linux cooked interface. Every source address and port is
+ * a client. IPv4 fragments and any other traffic are skipped.
+ *************************************************************************************************/
+class CaptureReader
+{
+public:
+    static constexpr uint32_t linktype_ethernet = 1;
+    static constexpr uint32_t linktype_raw = 101;
+    static constexpr uint32_t linktype_linux_sll = 113;
+
+    static bool load(
+            const std::string& path,
+            uint16_t agent_port,
+            ReplayCapture& capture);
+
+private:
+    static uint32_t to_host(
+            uint32_t value,
+            bool swapped)
+    {
+        return swapped ? __builtin_bswap32(value) : value;
+    }
+
+    static const uint8_t* ip_header(
+            uint32_t linktype,
+            const uint8_t* frame,
+            size_t& len);
+};
+
+constexpr uint32_t CaptureReader::linktype_ethernet;
+constexpr uint32_t CaptureReader::linktype_raw;
+constexpr uint32_t CaptureReader::linktype_linux_sll;
+
+inline const uint8_t* CaptureReader::ip_header(
+        uint32_t linktype,
+        const uint8_t* frame,
+        size_t& len)
+{
+    size_t offset = 0;
+    uint16_t protocol = 0x0800;
+    switch (linktype)
+    {
+        case linktype_raw:
+            break;
+        case linktype_ethernet:
+            offset = 14;
+            protocol = (len >= offset) ? uint16_t((frame[12] << 8) | frame[13]) : 0;
+            break;
+        case linktype_linux_sll:
+            offset = 16;
+            protocol = (len >= offset) ? uint16_t((frame[14] << 8) | frame[15]) : 0;
+            break;
+        default:
+            return nullptr;
+    }
+    if ((0x0800 != protocol) || (len < offset + 20) || (4 != (frame[offset] >> 4)))
+    {
+        return nullptr;
+    }
+    len -= offset;
+    return frame + offset;
+}
+
+inline bool CaptureReader::load(
+        const std::string& path,
+        uint16_t agent_port,
+        ReplayCapture& capture)
+{
+    capture = ReplayCapture{};
+    FILE* file = fopen(path.c_str(), "rb");
+    if (nullptr == file)
+    {
+        return false;
+    }
+
+    uint32_t header[6] = {};
+    bool rv = (1 == fread(header, sizeof(header), 1, file));
+    bool swapped = rv && ((0xd4c3b2a1 == header[0]) || (0x4d3cb2a1 == header[0]));
+    bool nanoseconds = rv && ((0xa1b23c4d == header[0]) || (0x4d3cb2a1 == header[0]));
+    rv = rv && (swapped || nanoseconds || (0xa1b2c3d4 == header[0]));
+    uint32_t linktype = to_host(header[5], swapped) & 0xFFFF;
+
+    std::map<std::pair<uint32_t, uint16_t>, size_t> clients;
+    std::chrono::nanoseconds first_timestamp{-1};
+    std::vector<uint8_t> frame;
+    uint32_t record[4] = {};
+    while (rv && (1 == fread(record, sizeof(record), 1, file)))
+    {
+        size_t len = to_host(record[2], swapped);
+        frame.resize(len);
+        if ((0 != len) && (1 != fread(frame.data(), len, 1, file)))
+        {
+            break;
+        }
+
+        const uint8_t* ip = ip_header(linktype, frame.data(), len);
+        size_t ip_len = (nullptr != ip) ? size_t(ip[0] & 0x0F) * 4 : 0;
+        bool fragment = (nullptr != ip) && (0 != (((ip[6] << 8) | ip[7]) & 0x3FFF));
+        if ((nullptr == ip) || fragment || (17 != ip[9]) || (len < ip_len + 8)
+            || (agent_port != uint16_t((ip[ip_len + 2] << 8) | ip[ip_len + 3])))
+        {
+            ++capture.skipped;
+            continue;
+        }
+
+        uint32_t src_address;
+        memcpy(&src_address, ip + 12, sizeof(src_address));
+        uint16_t src_port = uint16_t((ip[ip_len] << 8) | ip[ip_len + 1]);
+        size_t udp_len = size_t((ip[ip_len + 4] << 8) | ip[ip_len + 5]);
+        size_t payload_len = std::min(len - ip_len, udp_len) - std::min(udp_len, size_t(8));
+
+        std::chrono::nanoseconds timestamp = std::chrono::seconds(to_host(record[0], swapped))
+                + (nanoseconds ? std::chrono::nanoseconds(to_host(record[1], swapped))
+                               : std::chrono::microseconds(to_host(record[1], swapped)));
+        if (0 > first_timestamp.count())
+        {
+            first_timestamp = timestamp;
+        }
+
+        auto client = clients.emplace(std::make_pair(src_address, src_port), clients.size()).first;
+        const uint8_t* payload = ip + ip_len + 8;
+        capture.frames.push_back(ReplayFrame{timestamp - first_timestamp, client->second,
+                std::vector<uint8_t>(payload, payload + payload_len)});
+        capture.bytes += payload_len;
+    }
+
+    capture.clients = clients.size();
+    fclose(file);
+    return rv;
+}
+
+/*************************************************************************************************
+ * Traffic Replay
+ *
+ * Re-sends the frames of a capture to an agent, each client of the capture through a socket of
+ * its own, so that the agent sees as many clients and creates their sessions again. Frames are
+ * sent at their capture time, scaled by a speed factor, or back to back.
+ *
+ * A thread drains the replies of the agent. Its processing time lasts until the last reply, once
+ * no reply has been received for the idle time after the last frame. The usage of the process
+ * during the replay, without that of the replay threads, is the one of an embedded agent.
+ *************************************************************************************************/
+class TrafficReplay
+{
+public:
+    TrafficReplay(
+            TransportKind transport_kind,
+            PacerStrategy pacer)
+        : transport_kind_{transport_kind}
+        , pacer_{pacer}
+        , fds_{}
+        , pending_{}
+        , prefix_{}
+        , running_{false}
+        , replies_{0}
+        , reply_bytes_{0}
+        , last_reply_{0}
+    {}
+
+    ~TrafficReplay()
+    {
+        for (auto fd : fds_)
+        {
+            (void) close(fd);
+        }
+    }
+
+    bool connect(
+            const std::string& ip,
+            uint16_t port,
+            size_t clients);
+
+    ReplayResult run(
+            const ReplayCapture& capture,
+            ReplaySpeed speed,
+            double scale,
+            std::chrono::milliseconds idle);
+
+private:
+    bool send(
+            size_t client,
+            const std::vector<uint8_t>& data);
+
+    void receive(
+            RatePacer::Clock::time_point start,
+            ResourceUsage& usage);
+
+private:
+    TransportKind transport_kind_;
+    RatePacer pacer_;
+    std::vector<int> fds_;
+    /* Bytes left of the TCP message being received on each connection, header included. */
+    std::vector<size_t> pending_;
+    /* First byte of a length prefix split across chunks on each connection, -1 if none. */
+    std::vector<int> prefix_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> replies_;
+    std::atomic<uint64_t> reply_bytes_;
+    std::atomic<int64_t> last_reply_;
+};
+
+inline bool TrafficReplay::connect(
+        const std::string& ip,
+        uint16_t port,
+        size_t clients)
+{
+    sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    if (1 != inet_pton(AF_INET, ip.c_str(), &address.sin_addr))
+    {
+        return false;
+    }
+
+    bool tcp = (TransportKind::tcp == transport_kind_);
+    for (size_t i = 0; i < clients; ++i)
+    {
+        int fd = socket(AF_INET, tcp ? SOCK_STREAM : SOCK_DGRAM, 0);
+        if (-1 == fd)
+        {
+            return false;
+        }
+        fds_.push_back(fd);
+        pending_.push_back(0);
+        prefix_.push_back(-1);
+
+        int nodelay = 1;
+        if ((tcp && (0 != setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay))))
+            || (0 != ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * XRCE messages over TCP are framed by their length, as two little-endian bytes.
+ */
+inline bool TrafficReplay::send(
+        size_t client,
+        const std::vector<uint8_t>& data)
+{
+    if (TransportKind::tcp != transport_kind_)
+    {
+        return ssize_t(data.size()) == ::send(fds_[client], data.data(), data.size(), 0);
+    }
+
+    uint8_t length[2] = {uint8_t(data.size() & 0xFF), uint8_t((data.size() >> 8) & 0xFF)};
+    iovec chunks[2] = {{length, sizeof(length)}, {const_cast<uint8_t*>(data.data()), data.size()}};
+    msghdr message = {};
+    message.msg_iov = chunks;
+    message.msg_iovlen = 2;
+    size_t total = sizeof(length) + data.size();
+    size_t sent = 0;
+    while (sent < total)
+    {
+        ssize_t rv = sendmsg(fds_[client], &message, MSG_NOSIGNAL);
+        if (0 >= rv)
+        {
+            return false;
+        }
+        sent += size_t(rv);
+        for (size_t consumed = size_t(rv); 0 < consumed;)
+        {
+            size_t step = std::min(consumed, message.msg_iov->iov_len);
+            message.msg_iov->iov_base = static_cast<uint8_t*>(message.msg_iov->iov_base) + step;
+            message.msg_iov->iov_len -= step;
+            consumed -= step;
+            if (0 == message.msg_iov->iov_len)
+            {
+                ++message.msg_iov;
+                --message.msg_iovlen;
+            }
+        }
+    }
+    return true;
+}
+
+inline void TrafficReplay::receive(
+        RatePacer::Clock::time_point start,
+        ResourceUsage& usage)
+{
+    ResourceUsage usage_begin = {};
+    (void) read_thread_usage(usage_begin);
+
+    std::vector<pollfd> fds;
+    for (auto fd : fds_)
+    {
+        fds.push_back(pollfd{fd, POLLIN, 0});
+    }
+    std::vector<uint8_t> buffer(UINT16_MAX + 2);
+    while (running_.load(std::memory_order_relaxed))
+    {
+        if (0 >= poll(fds.data(), fds.size(), 10))
+        {
+            continue;
+        }
+        for (size_t i = 0; i < fds.size(); ++i)
+        {
+            ssize_t len = (0 != (fds[i].revents & POLLIN)) ? recv(fds[i].fd, buffer.data(), buffer.size(), 0) : 0;
+            if (0 >= len)
+            {
+                continue;
+            }
+            last_reply_.store((RatePacer::Clock::now() - start).count(), std::memory_order_relaxed);
+            reply_bytes_.fetch_add(uint64_t(len), std::memory_order_relaxed);
+            if (TransportKind::tcp != transport_kind_)
+            {
+                replies_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+
+            /* Every length prefix which ends in this chunk starts a new message. */
+            for (ssize_t offset = 0; offset < len;)
+            {
+                if (-1 != prefix_[i])
+                {
+                    pending_[i] = size_t(prefix_[i] | (buffer[offset] << 8));
+                    prefix_[i] = -1;
+                    offset += 1;
+                    replies_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                if (0 == pending_[i])
+                {
+                    if (offset + 1 >= len)
+                    {
+                        prefix_[i] = buffer[offset];
+                        break;
+                    }
+                    pending_[i] = 2 + size_t(buffer[offset] | (buffer[offset + 1] << 8));
+                    replies_.fetch_add(1, std::memory_order_relaxed);
+                }
+                size_t step = std::min(pending_[i], size_t(len - offset));
+                pending_[i] -= step;
+                offset += ssize_t(step);
+            }
+        }
+    }
+
+    ResourceUsage usage_end = {};
+    (void) read_thread_usage(usage_end);
+    usage = usage_delta(usage_end, usage_begin);
+}
+
+inline ReplayResult TrafficReplay::run(
+        const ReplayCapture& capture,
+        ReplaySpeed speed,
+        double scale,
+        std::chrono::milliseconds idle)
+{
+    ReplayResult result = {};
+    ResourceUsage process_begin = {};
+    ResourceUsage sender_begin = {};
+    ResourceUsage receiver_usage = {};
+    bool usage = read_process_usage(0, process_begin) && read_thread_usage(sender_begin);
+
+    RatePacer::Clock::time_point start = RatePacer::Clock::now();
+    running_ = true;
+    std::thread receiver(&TrafficReplay::receive, this, start, std::ref(receiver_usage));
+
+    double factor = (ReplaySpeed::SCALED == speed) ? 1.0 / scale : 1.0;
+    for (const auto& frame : capture.frames)
+    {
+        if (ReplaySpeed::FAST != speed)
+        {
+            pacer_.wait_until(start + std::chrono::nanoseconds(
+                    std::chrono::nanoseconds::rep(double(frame.timestamp.count()) * factor)));
+        }
+        if (send(frame.client, frame.data))
+        {
+            ++result.frames;
+            result.bytes += frame.data.size();
+        }
+        else
+        {
+            ++result.send_errors;
+        }
+    }
+    result.send_time = RatePacer::Clock::now() - start;
+
+    /* The agent is done once it has not replied for the idle time. */
+    std::chrono::nanoseconds last_activity = result.send_time;
+    while (RatePacer::Clock::now() - start < last_activity + idle)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        last_activity = std::max(result.send_time,
+                std::chrono::nanoseconds(last_reply_.load(std::memory_order_relaxed)));
+    }
+    result.processing_time = last_activity;
+
+    running_ = false;
+    receiver.join();
+    result.replies = replies_;
+    result.reply_bytes = reply_bytes_;
+
+    ResourceUsage process_end = {};
+    ResourceUsage sender_end = {};
+    if (usage && read_process_usage(0, process_end) && read_thread_usage(sender_end))
+    {
+        result.agent_usage = usage_delta(process_end, process_begin);
+        exclude_usage(result.agent_usage, usage_delta(sender_end, sender_begin));
+        exclude_usage(result.agent_usage, receiver_usage);
+    }
+    return result;
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCEREPLAY_HPP
@@ -0,0 +1,331 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCERESULT_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCERESULT_HPP
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+constexpr size_t sep_width = 30;
+
+enum class ResultFormat : uint8_t
+{
+    TABLE,
+    CSV,
+    JSON
+};
+
+struct ResultField
+{
+    std::string name;
+    std::string unit;
+    std::string value;
+    bool numeric;
+};
+
+/*
+ * Ordered set of named values of one result row, or of the metadata shared by all the rows.
+ */
+class ResultRecord
+{
+public:
+    template<typename T>
+    ResultRecord& add(
+            const std::string& name,
+            const std::string& unit,
+            T value,
+            int precision = 0)
+    {
+        std::ostringstream os;
+        os.setf(std::ios::fixed);
+        os << std::setprecision(precision) << value;
+        fields_.push_back(ResultField{name, unit, os.str(), true});
+        return *this;
+    }
+
+    ResultRecord& add_text(
+            const std::string& name,
+            const std::string& value)
+    {
+        fields_.push_back(ResultField{name, "", value, false});
+        return *this;
+    }
+
+    const std::vector<ResultField>& get_fields() const { return fields_; }
+
+private:
+    std::vector<ResultField> fields_;
+};
+
+/*************************************************************************************************
+ * Result Writers
+ *
+ * A writer owns the numbering of the runs: begin_run() is called for every measured run, and the
+ * "run" column of the rows, as well as the run field of the sample trace, refer to that number.
+ *************************************************************************************************/
+class ResultWriter
+{
+public:
+    ResultWriter(
+            std::ostream& os,
+            const ResultRecord& metadata)
+        : os_(os)
+        , metadata_(metadata)
+        , header_{}
+        , run_count_{0}
+    {}
+
+    virtual ~ResultWriter() = default;
+
+    static std::unique_ptr<ResultWriter> create(
+            ResultFormat format,
+            std::ostream& os,
+            const ResultRecord& metadata);
+
+    uint32_t begin_run() { return ++run_count_; }
+
+    /*
+     * The header is (re)emitted whenever the columns differ from those of the previous row.
+     */
+    void write(
+            const ResultRecord& record)
+    {
+        std::vector<std::string> header;
+        for (const auto& field : record.get_fields())
+        {
+            header.push_back(field.name);
+        }
+        if (header != header_)
+        {
+            header_ = header;
+            write_header(record);
+        }
+        write_row(record);
+        os_.flush();
+    }
+
+protected:
+    static std::string column_name(
+            const ResultField& field,
+            const std::string& separator)
+    {
+        return field.unit.empty() ? field.name : field.name + separator + field.unit;
+    }
+
+private:
+    virtual void write_header(
+            const ResultRecord& record) = 0;
+
+    virtual void write_row(
+            const ResultRecord& record) = 0;
+
+protected:
+    std::ostream& os_;
+    ResultRecord metadata_;
+
+private:
+    std::vector<std::string> header_;
+    uint32_t run_count_;
+};
+
+/*
+ * Fixed-width columns, as parsed by PerformanceAnalisys.py. Metadata is not printed.
+ */
+class TableResultWriter : public ResultWriter
+{
+public:
+    using ResultWriter::ResultWriter;
+
+private:
+    void write_header(
+            const ResultRecord& record) final
+    {
+        for (const auto& field : record.get_fields())
+        {
+            os_ << std::setw(sep_width) << (field.unit.empty() ? field.name : field.name + "(" + field.unit + ")");
+        }
+        os_ << std::endl;
+    }
+
+    void write_row(
+            const ResultRecord& record) final
+    {
+        for (const auto& field : record.get_fields())
+        {
+            os_ << std::setw(sep_width) << field.value;
+        }
+        os_ << std::endl;
+    }
+};
+
+/*
+ * RFC 4180 rows prefixed by the metadata columns.
+ */
+class CsvResultWriter : public ResultWriter
+{
+public:
+    using ResultWriter::ResultWriter;
+
+private:
+    static std::string quote(
+            const std::string& value)
+    {
+        if (std::string::npos == value.find_first_of(",\"\n"))
+        {
+            return value;
+        }
+        std::string quoted = "\"";
+        for (char c : value)
+        {
+            quoted += ('"' == c) ? std::string("\"\"") : std::string(1, c);
+        }
+        return quoted + "\"";
+    }
+
+    void write_fields(
+            const std::vector<ResultField>& fields,
+            bool names,
+            bool& first)
+    {
+        for (const auto& field : fields)
+        {
+            os_ << (first ? "" : ",") << quote(names ? column_name(field, "_") : field.value);
+            first = false;
+        }
+    }
+
+    void write_header(
+            const ResultRecord& record) final
+    {
+        bool first = true;
+        write_fields(metadata_.get_fields(), true, first);
+        write_fields(record.get_fields(), true, first);
+        os_ << "\n";
+    }
+
+    void write_row(
+            const ResultRecord& record) final
+    {
+        bool first = true;
+        write_fields(metadata_.get_fields(), false, first);
+        write_fields(record.get_fields(), false, first);
+        os_ << "\n";
+    }
+};
+
+/*
+ * JSON Lines: one self-contained object per row, with the metadata under its own key.
+ */
+class JsonResultWriter : public ResultWriter
+{
+public:
+    using ResultWriter::ResultWriter;
+
+private:
+    static std::string escape(
+            const std::string& value)
+    {
+        std::ostringstream escaped;
+        for (char c : value)
+        {
+            switch (c)
+            {
+                case '"': escaped << "\\\""; break;
+                case '\\': escaped << "\\\\"; break;
+                case '\n': escaped << "\\n"; break;
+                case '\t': escaped << "\\t"; break;
+                default:
+                    if (0x20 > static_cast<unsigned char>(c))
+                    {
+                        escaped << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c);
+                    }
+                    else
+                    {
+                        escaped << c;
+                    }
+            }
+        }
+        return escaped.str();
+    }
+
+    void write_object(
+            const std::vector<ResultField>& fields)
+    {
+        os_ << "{";
+        bool first = true;
+        for (const auto& field : fields)
+        {
+            os_ << (first ? "" : ",") << "\"" << escape(column_name(field, "_")) << "\":";
+            if (field.numeric)
+            {
+                /* nan and inf have no JSON representation. */
+                os_ << ((std::string::npos == field.value.find_first_of("an")) ? field.value : "null");
+            }
+            else
+            {
+                os_ << "\"" << escape(field.value) << "\"";
+            }
+            first = false;
+        }
+        os_ << "}";
+    }
+
+    void write_header(
+            const ResultRecord& record) final
+    {
+        (void) record;
+    }
+
+    void write_row(
+            const ResultRecord& record) final
+    {
+        os_ << "{\"metadata\":";
+        write_object(metadata_.get_fields());
+        os_ << ",\"result\":";
+        write_object(record.get_fields());
+        os_ << "}\n";
+    }
+};
+
+inline std::unique_ptr<ResultWriter> ResultWriter::create(
+        ResultFormat format,
+        std::ostream& os,
+        const ResultRecord& metadata)
+{
+    switch (format)
+    {
+        case ResultFormat::CSV:
+            return std::unique_ptr<ResultWriter>(new CsvResultWriter(os, metadata));
+        case ResultFormat::JSON:
+            return std::unique_ptr<ResultWriter>(new JsonResultWriter(os, metadata));
+        case ResultFormat::TABLE:
+        default:
+            return std::unique_ptr<ResultWriter>(new TableResultWriter(os, metadata));
+    }
+}
+
+/*
+ * Build configuration of the running binary, part of every run metadata.
+ */
+inline void add_build_metadata(
+        ResultRecord& metadata)
+{
+#ifdef NDEBUG
+    metadata.add_text("build_type", "release");
+#else
+    metadata.add_text("build_type", "debug");
+#endif // NDEBUG
+#if defined(__clang__)
+    metadata.add_text("compiler", std::string("clang ") + __clang_version__);
+#elif defined(__GNUC__)
+    metadata.add_text("compiler", std::string("gcc ") + __VERSION__);
+#elif defined(_MSC_VER)
+    metadata.add("compiler_msvc", "", _MSC_VER);
+#endif
+    metadata.add("cxx_standard", "", long(__cplusplus));
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCERESULT_HPP
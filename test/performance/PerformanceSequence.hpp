@@ -0,0 +1,215 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCESEQUENCE_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCESEQUENCE_HPP
+
+#include <bitset>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+struct SequenceStats
+{
+    uint64_t received;
+    uint64_t lost;
+    uint64_t duplicated;
+    uint64_t reordered;
+    uint64_t late;
+    uint64_t max_burst;
+};
+
+/*
+ * Loss ratio (%) of the time windows of a run: uniform losses spread over most windows, while
+ * bursts are concentrated in a few of them.
+ */
+struct WindowLoss
+{
+    uint64_t windows;
+    uint64_t lossy_windows;
+    double max;
+    double std;
+};
+
+/*************************************************************************************************
+ * Sequence Tracker
+ *
+ * Accounts the sequence numbers a subscriber receives during a run, which the publisher numbers
+ * from 0. A sample is lost while any newer one has been received but not itself, so that samples
+ * sent after the subscriber stopped are never counted as lost. A sample older than the newest one
+ * is reordered when it arrives within the last reorder_window sequence numbers, and late beyond
+ * them, where duplicates can no longer be told apart.
+ *
+ * Losses are also counted per time window of the publication timestamps, the windows of a run
+ * being reserved beforehand so that the topic callback does not allocate.
+ *************************************************************************************************/
+class SequenceTracker
+{
+public:
+    static constexpr uint32_t reorder_window = 1024;
+
+    struct Window
+    {
+        uint64_t received;
+        uint64_t lost;
+    };
+
+    SequenceTracker()
+        : stats_{}
+        , received_{}
+        , newest_{0}
+        , started_{false}
+        , first_timestamp_{0}
+        , window_{std::chrono::milliseconds{100}}
+        , windows_{}
+    {}
+
+    void reset(
+            std::chrono::nanoseconds window,
+            std::chrono::nanoseconds duration)
+    {
+        stats_ = SequenceStats{};
+        received_.reset();
+        newest_ = 0;
+        started_ = false;
+        first_timestamp_ = 0;
+        window_ = (0 < window.count()) ? window : duration;
+        windows_.clear();
+        windows_.reserve(size_t(duration / window_) + 2);
+    }
+
+    /*
+     * Sequence number and publication timestamp (ns) of a received sample.
+     */
+    void record(
+            uint32_t seq_num,
+            uint64_t timestamp);
+
+    const SequenceStats& get_stats() const { return stats_; }
+    const std::vector<Window>& get_windows() const { return windows_; }
+    std::chrono::nanoseconds get_window() const { return window_; }
+    WindowLoss get_window_loss() const;
+
+    /*
+     * The dump is a header line followed by one "<window> <received> <lost>" line per window.
+     * It is skipped by LatencyHistogram::load(), so it can share the histogram output.
+     */
+    void dump(
+            std::ostream& os,
+            const std::string& label) const;
+
+private:
+    Window& window_of(
+            uint64_t timestamp);
+
+private:
+    SequenceStats stats_;
+    std::bitset<reorder_window> received_;
+    uint32_t newest_;
+    bool started_;
+    uint64_t first_timestamp_;
+    std::chrono::nanoseconds window_;
+    std::vector<Window> windows_;
+};
+
+inline void SequenceTracker::record(
+        uint32_t seq_num,
+        uint64_t timestamp)
+{
+    if (!started_)
+    {
+        first_timestamp_ = timestamp;
+    }
+    Window& window = window_of(timestamp);
+
+    if (!started_ || (0 < int32_t(seq_num - newest_)))
+    {
+        /* Every sequence number skipped is lost until it arrives. */
+        uint32_t gap = started_ ? seq_num - newest_ - 1 : seq_num;
+        for (uint32_t i = 1; started_ && (i <= gap) && (i < reorder_window); ++i)
+        {
+            received_.reset((seq_num - i) % reorder_window);
+        }
+        received_.set(seq_num % reorder_window);
+        newest_ = seq_num;
+        started_ = true;
+
+        ++stats_.received;
+        ++window.received;
+        stats_.lost += gap;
+        window.lost += gap;
+        stats_.max_burst = (gap > stats_.max_burst) ? gap : stats_.max_burst;
+        return;
+    }
+
+    if (newest_ - seq_num >= reorder_window)
+    {
+        ++stats_.late;
+    }
+    else if (received_.test(seq_num % reorder_window))
+    {
+        ++stats_.duplicated;
+        return;
+    }
+    else
+    {
+        received_.set(seq_num % reorder_window);
+        ++stats_.reordered;
+    }
+
+    /* The sample was counted as lost when a newer one arrived. */
+    ++stats_.received;
+    ++window.received;
+    stats_.lost -= (0 < stats_.lost) ? 1 : 0;
+    window.lost -= (0 < window.lost) ? 1 : 0;
+}
+
+inline SequenceTracker::Window& SequenceTracker::window_of(
+        uint64_t timestamp)
+{
+    uint64_t offset = (timestamp > first_timestamp_) ? timestamp - first_timestamp_ : 0;
+    size_t index = size_t(offset / uint64_t(window_.count()));
+    if (index >= windows_.size())
+    {
+        windows_.resize(index + 1, Window{0, 0});
+    }
+    return windows_[index];
+}
+
+inline WindowLoss SequenceTracker::get_window_loss() const
+{
+    WindowLoss window_loss = {};
+    double loss_sum = 0.0;
+    double loss_sum_2 = 0.0;
+    for (const auto& window : windows_)
+    {
+        uint64_t expected = window.received + window.lost;
+        double loss = (0 != expected) ? 100.0 * double(window.lost) / double(expected) : 0.0;
+        window_loss.lossy_windows += (0 != window.lost) ? 1 : 0;
+        window_loss.max = (loss > window_loss.max) ? loss : window_loss.max;
+        loss_sum += loss;
+        loss_sum_2 += loss * loss;
+    }
+    window_loss.windows = windows_.size();
+    if (!windows_.empty())
+    {
+        double mean = loss_sum / double(windows_.size());
+        double variance = loss_sum_2 / double(windows_.size()) - mean * mean;
+        window_loss.std = std::sqrt((0.0 < variance) ? variance : 0.0);
+    }
+    return window_loss;
+}
+
+inline void SequenceTracker::dump(
+        std::ostream& os,
+        const std::string& label) const
+{
+    os << "loss " << label << " " << window_.count() << " " << windows_.size() << std::endl;
+    for (size_t i = 0; i < windows_.size(); ++i)
+    {
+        os << i << " " << windows_[i].received << " " << windows_[i].lost << std::endl;
+    }
+    os << "end" << std::endl;
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCESEQUENCE_HPP
@@ -2,33 +2,92 @@
 #define IN_TEST_PERFORMANCE_PERFORMANCESUBSCRIBER_HPP
 
 #include "PerformanceClient.hpp"
+#include "PerformanceHistogram.hpp"
+#include "PerformanceSequence.hpp"
 #include "PerformanceTopic.hpp"
 #include <EntitiesInfo.hpp>
 
 #include <thread>
 #include <cmath>
 
+/*
+ * How the subscriber waits for data: polling the transport without ever blocking, blocking in it up
+ * to a timeout, or polling for a while after every reception and blocking once the link is idle.
+ */
+enum class ReceiveStrategy : uint8_t
+{
+    BUSY,
+    BLOCKING,
+    ADAPTIVE
+};
+
 template<MiddlewareKind MK>
 class PerformanceSubscriber : public PerformanceClient
 {
 public:
-    PerformanceSubscriber() {}
+    PerformanceSubscriber()
+        : receive_strategy_{ReceiveStrategy::BUSY}
+        , receive_timeout_{10}
+        , receive_spin_{50}
+        , loss_window_{100}
+    {}
 
     ~PerformanceSubscriber() override = default;
 
-    template<size_t Size, typename D>
+    template<typename D>
     void subscribe(
+            size_t size,
             D duration);
 
+    /*
+     * Keeps receiving after subscribe() until the samples of the last subscription add up to sent,
+     * or until none arrives for the idle time. Returns whether all of them were received.
+     */
+    bool drain(
+            uint64_t sent,
+            std::chrono::milliseconds idle);
+
+    /*
+     * Set before subscribe(). The spin time only applies to the adaptive strategy.
+     */
+    void set_receive_strategy(
+            ReceiveStrategy strategy,
+            std::chrono::milliseconds timeout,
+            std::chrono::microseconds spin)
+    {
+        receive_strategy_ = strategy;
+        receive_timeout_ = timeout;
+        receive_spin_ = spin;
+    }
+
+    /*
+     * Time windows, of the publication timestamps, in which the losses of a run are counted.
+     */
+    void set_loss_window(
+            std::chrono::milliseconds window)
+    {
+        loss_window_ = window;
+    }
+
     double get_latency_avg() { return latency_avg_; }
     double get_latency_std() { return latency_std_; }
     uint64_t get_throughput() { return throughput_; }
     uint64_t get_msg_count() { return msg_count_; }
+    const LatencyHistogram& get_histogram() const { return histogram_; }
+    const SequenceTracker& get_sequence_tracker() const { return sequence_tracker_; }
+
+    /*
+     * Time from the reception of the first fragment of a sample to its delivery, for the samples
+     * which were fragmented.
+     */
+    const LatencyHistogram& get_reassembly_histogram() const { return reassembly_histogram_; }
 
 private:
     bool create_entities() final;
 
-    template<size_t Size>
+    void receive(
+            std::chrono::steady_clock::time_point& last_reception);
+
     static void topic_callback_dispatcher(
             uxrSession* session,
             uxrObjectId object_id,
@@ -37,7 +96,6 @@ private:
             ucdrBuffer* serialization,
             void* args);
 
-    template<size_t Size>
     void topic_callback(
             uxrSession* session,
             uxrObjectId object_id,
@@ -58,6 +116,7 @@ private:
 private:
     static uint16_t entities_prefix_;
 
+    size_t msg_size_;
     double latency_avg_;
     double latency_sum_;
     double latency_sum_2_;
@@ -65,19 +124,30 @@ private:
     double latency_ref_;
     uint64_t throughput_;
     uint64_t msg_count_;
+    LatencyHistogram histogram_;
+    LatencyHistogram reassembly_histogram_;
+    ReceiveStrategy receive_strategy_;
+    std::chrono::milliseconds receive_timeout_;
+    std::chrono::microseconds receive_spin_;
+    std::chrono::milliseconds loss_window_;
+    SequenceTracker sequence_tracker_;
 };
 
 template<MiddlewareKind MK>
-template<size_t Size, typename D>
+template<typename D>
 inline void PerformanceSubscriber<MK>::subscribe(
+        size_t size,
         D duration)
 {
     init_subscription();
+    sequence_tracker_.reset(loss_window_, duration);
+    arena_.reserve(size);
+    msg_size_ = size;
 
-    uxr_set_topic_callback(&session_, topic_callback_dispatcher<Size>, this);
+    uxr_set_topic_callback(&session_, topic_callback_dispatcher, this);
 
     uxrStreamId output_stream_id = uxr_stream_id(0, UXR_RELIABLE_STREAM, UXR_OUTPUT_STREAM);
-    uxrStreamId input_stream_id = uxr_stream_id_from_raw(0x01, UXR_INPUT_STREAM);
+    uxrStreamId input_stream_id = uxr_stream_id_from_raw(get_data_stream_raw(), UXR_INPUT_STREAM);
     uxrObjectId datareader_id = uxr_object_id(entities_prefix_, UXR_DATAREADER_ID);
 
     uxrDeliveryControl delivery_control = {};
@@ -88,15 +158,62 @@ inline void PerformanceSubscriber<MK>::subscribe(
     std::chrono::time_point<std::chrono::high_resolution_clock> init_time;
     std::chrono::time_point<std::chrono::high_resolution_clock> current_time;
 
+    std::chrono::steady_clock::time_point last_reception = std::chrono::steady_clock::now();
+    begin_usage();
     init_time = std::chrono::high_resolution_clock::now();
     while (elapsed_time < duration)
     {
-        uxr_run_session_until_timeout(&session_, 0);
+        receive(last_reception);
         current_time = std::chrono::high_resolution_clock::now();
         elapsed_time = std::chrono::duration_cast<D>(current_time - init_time);
     }
+    end_usage();
+
+    fini_subscription(elapsed_time, size);
+}
+
+template<MiddlewareKind MK>
+inline bool PerformanceSubscriber<MK>::drain(
+        uint64_t sent,
+        std::chrono::milliseconds idle)
+{
+    std::chrono::steady_clock::time_point last_reception = std::chrono::steady_clock::now();
+    while ((msg_count_ < sent) && ((std::chrono::steady_clock::now() - last_reception) < idle))
+    {
+        uint64_t received = msg_count_;
+        (void) uxr_run_session_until_timeout(&session_, int(receive_timeout_.count()));
+        if (received != msg_count_)
+        {
+            last_reception = std::chrono::steady_clock::now();
+        }
+    }
+    return msg_count_ >= sent;
+}
 
-    fini_subscription(elapsed_time, Size);
+template<MiddlewareKind MK>
+inline void PerformanceSubscriber<MK>::receive(
+        std::chrono::steady_clock::time_point& last_reception)
+{
+    int timeout = int(receive_timeout_.count());
+    switch (receive_strategy_)
+    {
+        case ReceiveStrategy::BUSY:
+            (void) uxr_run_session_until_timeout(&session_, 0);
+            break;
+        case ReceiveStrategy::BLOCKING:
+            (void) uxr_run_session_until_timeout(&session_, timeout);
+            break;
+        case ReceiveStrategy::ADAPTIVE:
+        {
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            bool idle = (now - last_reception) > receive_spin_;
+            if (uxr_run_session_until_timeout(&session_, idle ? timeout : 0))
+            {
+                last_reception = std::chrono::steady_clock::now();
+            }
+            break;
+        }
+    }
 }
 
 template<MiddlewareKind MK>
@@ -106,22 +223,21 @@ inline bool PerformanceSubscriber<MK>::create_entities()
 
     uint8_t flags = 0x00;
     uxrStreamId output_stream_id = uxr_stream_id_from_raw(0x01, UXR_OUTPUT_STREAM);
-    uint16_t request_id; uint8_t status;
+    uint16_t request_id;
 
     uxrObjectId participant_id = uxr_object_id(entities_prefix_, UXR_PARTICIPANT_ID);
     request_id = uxr_buffer_create_participant_xml(
         &session_, output_stream_id, participant_id, 11, EInfo::participant_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != participant_id) || (last_request_id_ != request_id))
+    if (!wait_status(participant_id, request_id))
     {
         return false;
     }
 
     uxrObjectId topic_id = uxr_object_id(entities_prefix_, UXR_TOPIC_ID);
     request_id = uxr_buffer_create_topic_xml(
-        &session_, output_stream_id, topic_id, participant_id, EInfo::topic_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != topic_id) || (last_request_id_ != request_id))
+        &session_, output_stream_id, topic_id, participant_id,
+        with_topic_suffix(EInfo::topic_xml, EInfo::topic_name).c_str(), flags);
+    if (!wait_status(topic_id, request_id))
     {
         return false;
     }
@@ -129,17 +245,16 @@ inline bool PerformanceSubscriber<MK>::create_entities()
     uxrObjectId subscriber_id = uxr_object_id(entities_prefix_, UXR_SUBSCRIBER_ID);
     request_id = uxr_buffer_create_subscriber_xml(
         &session_, output_stream_id, subscriber_id, participant_id, EInfo::subscriber_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != subscriber_id) || (last_request_id_ != request_id))
+    if (!wait_status(subscriber_id, request_id))
     {
         return false;
     }
 
     uxrObjectId datareader_id = uxr_object_id(entities_prefix_, UXR_DATAREADER_ID);
     request_id = uxr_buffer_create_datareader_xml(
-        &session_, output_stream_id, datareader_id, subscriber_id, EInfo::datareader_xml, flags);
-    uxr_run_session_until_all_status(&session_, 3000, &request_id, &status, 1);
-    if ((UXR_STATUS_OK != status) || (last_object_id_ != datareader_id) || (last_request_id_ != request_id))
+        &session_, output_stream_id, datareader_id, subscriber_id,
+        with_topic_suffix(EInfo::datareader_xml, EInfo::topic_name).c_str(), flags);
+    if (!wait_status(datareader_id, request_id))
     {
         return false;
     }
@@ -148,7 +263,6 @@ inline bool PerformanceSubscriber<MK>::create_entities()
 }
 
 template<MiddlewareKind MK>
-template<size_t Size>
 inline void PerformanceSubscriber<MK>::topic_callback_dispatcher(
         uxrSession* session,
         uxrObjectId object_id,
@@ -157,11 +271,10 @@ inline void PerformanceSubscriber<MK>::topic_callback_dispatcher(
         ucdrBuffer* serialization,
         void* args)
 {
-    static_cast<PerformanceSubscriber*>(args)->topic_callback<Size>(session, object_id, request_id, stream_id, serialization);
+    static_cast<PerformanceSubscriber*>(args)->topic_callback(session, object_id, request_id, stream_id, serialization);
 }
 
 template<MiddlewareKind MK>
-template<size_t Size>
 inline void PerformanceSubscriber<MK>::topic_callback(
         uxrSession* session,
         uxrObjectId object_id,
@@ -174,14 +287,32 @@ inline void PerformanceSubscriber<MK>::topic_callback(
     (void) request_id;
     (void) stream_id;
 
-    PerformanceTopic<Size> topic;
+    PerformanceTopic topic;
+    topic.data = arena_.data();
+    topic.size = msg_size_;
     topic.deserialize(*serialization);
     uint64_t timestamp = (uint64_t(topic.timestamp[0]) << 32) + topic.timestamp[1];
 
     std::chrono::nanoseconds epoch_time = std::chrono::high_resolution_clock::now().time_since_epoch();
 
+    int64_t latency = (epoch_time.count() - int64_t(timestamp)) / 2;
+
+    std::chrono::steady_clock::time_point fragment_begin;
+    if (monitor_.take_fragment_begin(fragment_begin))
+    {
+        std::chrono::nanoseconds reassembly = std::chrono::steady_clock::now() - fragment_begin;
+        reassembly_histogram_.record(uint64_t(reassembly.count()));
+    }
+
+    sequence_tracker_.record(topic.seq_num, timestamp);
     ++msg_count_;
-    processing_latency((epoch_time.count() - timestamp) / 2);
+    histogram_.record((0 < latency) ? uint64_t(latency) : 0);
+    processing_latency(double(latency));
+
+    if (nullptr != trace_)
+    {
+        trace_->record(trace_run_, uint32_t(msg_size_), timestamp, uint64_t(epoch_time.count()));
+    }
 }
 
 template<MiddlewareKind MK>
@@ -210,6 +341,9 @@ inline void PerformanceSubscriber<MK>::init_subscription()
     latency_std_ = 0;
     latency_ref_ = 0;
     msg_count_ = 0;
+    histogram_.reset();
+    reassembly_histogram_.reset();
+    monitor_.reset_stats();
 }
 
 template<MiddlewareKind MK>
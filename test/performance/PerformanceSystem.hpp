@@ -0,0 +1,510 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCESYSTEM_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCESYSTEM_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(PLATFORM_NAME_LINUX)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#elif defined(_MSC_VER)
+typedef int pid_t;
+#else
+#include <sys/types.h>
+#endif // PLATFORM_NAME_LINUX
+
+/*
+ * Resources consumed by a process or a thread. Times and counters accumulate, so runs are measured
+ * as the difference of two readings; memory (kB) is that of the whole process.
+ */
+struct ResourceUsage
+{
+    std::chrono::nanoseconds user_time;
+    std::chrono::nanoseconds system_time;
+    uint64_t voluntary_switches;
+    uint64_t involuntary_switches;
+    uint64_t syscalls;
+    int64_t rss;
+    int64_t rss_peak;
+};
+
+/*
+ * Removes from usage the times and counters of a part of it, such as one of its threads. Both
+ * being read from different sources, the result saturates at 0.
+ */
+inline void exclude_usage(
+        ResourceUsage& usage,
+        const ResourceUsage& part)
+{
+    usage.user_time = (usage.user_time > part.user_time)
+            ? usage.user_time - part.user_time : std::chrono::nanoseconds{0};
+    usage.system_time = (usage.system_time > part.system_time)
+            ? usage.system_time - part.system_time : std::chrono::nanoseconds{0};
+    usage.voluntary_switches = (usage.voluntary_switches > part.voluntary_switches)
+            ? usage.voluntary_switches - part.voluntary_switches : 0;
+    usage.involuntary_switches = (usage.involuntary_switches > part.involuntary_switches)
+            ? usage.involuntary_switches - part.involuntary_switches : 0;
+    usage.syscalls = (usage.syscalls > part.syscalls) ? usage.syscalls - part.syscalls : 0;
+}
+
+/*
+ * Usage between two readings. The resident set is given as its growth, the peak as the last one.
+ */
+inline ResourceUsage usage_delta(
+        const ResourceUsage& end,
+        const ResourceUsage& begin)
+{
+    ResourceUsage delta = end;
+    exclude_usage(delta, begin);
+    delta.rss -= begin.rss;
+    return delta;
+}
+
+/*
+ * Placement of a benchmark thread: the CPUs it may run on (any if empty) and its SCHED_FIFO
+ * priority (the default policy if 0).
+ */
+struct ThreadConfig
+{
+    std::vector<size_t> cpus;
+    int priority;
+};
+
+/*
+ * Comma-separated list of the CPUs of a ThreadConfig, as reported in the run metadata.
+ */
+inline std::string cpu_list(
+        const std::vector<size_t>& cpus)
+{
+    if (cpus.empty())
+    {
+        return "any";
+    }
+    std::string list;
+    for (auto cpu : cpus)
+    {
+        list += (list.empty() ? "" : ",") + std::to_string(cpu);
+    }
+    return list;
+}
+
+/*
+ * CPUs each thread of a process may run on, by thread id.
+ */
+using ProcessAffinity = std::map<pid_t, std::vector<size_t>>;
+
+#if defined(PLATFORM_NAME_LINUX)
+
+/*
+ * /proc directory of a process, a null pid being the calling process.
+ */
+inline std::string proc_path(
+        pid_t pid)
+{
+    return (0 == pid) ? std::string("/proc/self") : "/proc/" + std::to_string(pid);
+}
+
+/*
+ * User and system CPU times of a /proc stat file, of a process or of one of its threads.
+ */
+inline bool read_stat_times(
+        const std::string& stat_path,
+        std::chrono::nanoseconds& user_time,
+        std::chrono::nanoseconds& system_time)
+{
+    std::ifstream stat(stat_path);
+    std::string line;
+    if (!std::getline(stat, line))
+    {
+        return false;
+    }
+
+    /* The command name may contain spaces, fields are counted from its closing parenthesis. */
+    size_t pos = line.rfind(')');
+    if (std::string::npos == pos)
+    {
+        return false;
+    }
+
+    std::istringstream fields(line.substr(pos + 1));
+    std::string field;
+    unsigned long long utime = 0;
+    unsigned long long stime = 0;
+    for (int i = 3; i < 14; ++i)
+    {
+        fields >> field;
+    }
+    if (!(fields >> utime >> stime))
+    {
+        return false;
+    }
+
+    long ticks = sysconf(_SC_CLK_TCK);
+    user_time = std::chrono::nanoseconds(utime * (std::nano::den / ticks));
+    system_time = std::chrono::nanoseconds(stime * (std::nano::den / ticks));
+    return true;
+}
+
+/*
+ * "Key: value" lines of a /proc status or io file. Units, such as the kB of the memory fields,
+ * are dropped.
+ */
+inline std::map<std::string, uint64_t> read_proc_fields(
+        const std::string& path)
+{
+    std::map<std::string, uint64_t> fields;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t pos = line.find(':');
+        if (std::string::npos != pos)
+        {
+            std::istringstream value(line.substr(pos + 1));
+            uint64_t number = 0;
+            if (value >> number)
+            {
+                fields[line.substr(0, pos)] = number;
+            }
+        }
+    }
+    return fields;
+}
+
+/*
+ * Syscalls are those counted by the I/O accounting of the kernel, that is reads and writes, which
+ * is where the transports spend them. Missing accounting reads as 0.
+ */
+inline void read_memory_and_syscalls(
+        const std::string& process_path,
+        const std::string& io_path,
+        ResourceUsage& usage)
+{
+    std::map<std::string, uint64_t> status = read_proc_fields(process_path + "/status");
+    std::map<std::string, uint64_t> io = read_proc_fields(io_path);
+    usage.rss = int64_t(status["VmRSS"]);
+    usage.rss_peak = int64_t(status["VmHWM"]);
+    usage.syscalls = io["syscr"] + io["syscw"];
+}
+
+/*
+ * Usage of the calling thread.
+ */
+inline bool read_thread_usage(
+        ResourceUsage& usage)
+{
+    rusage thread_usage = {};
+    if (0 != getrusage(RUSAGE_THREAD, &thread_usage))
+    {
+        return false;
+    }
+    usage.user_time = std::chrono::seconds(thread_usage.ru_utime.tv_sec)
+            + std::chrono::microseconds(thread_usage.ru_utime.tv_usec);
+    usage.system_time = std::chrono::seconds(thread_usage.ru_stime.tv_sec)
+            + std::chrono::microseconds(thread_usage.ru_stime.tv_usec);
+    usage.voluntary_switches = uint64_t(thread_usage.ru_nvcsw);
+    usage.involuntary_switches = uint64_t(thread_usage.ru_nivcsw);
+
+    std::string task_path = proc_path(0) + "/task/" + std::to_string(long(syscall(SYS_gettid)));
+    read_memory_and_syscalls(proc_path(0), task_path + "/io", usage);
+    return true;
+}
+
+/*
+ * Usage of all the threads of a process, a null pid being the calling process.
+ */
+inline bool read_process_usage(
+        pid_t pid,
+        ResourceUsage& usage)
+{
+    if (!read_stat_times(proc_path(pid) + "/stat", usage.user_time, usage.system_time))
+    {
+        return false;
+    }
+
+    /* The status of a process only counts the context switches of its main thread. */
+    usage.voluntary_switches = 0;
+    usage.involuntary_switches = 0;
+    DIR* tasks = opendir((proc_path(pid) + "/task").c_str());
+    if (nullptr != tasks)
+    {
+        for (dirent* entry = readdir(tasks); nullptr != entry; entry = readdir(tasks))
+        {
+            if ('.' != entry->d_name[0])
+            {
+                std::map<std::string, uint64_t> status =
+                        read_proc_fields(proc_path(pid) + "/task/" + entry->d_name + "/status");
+                usage.voluntary_switches += status["voluntary_ctxt_switches"];
+                usage.involuntary_switches += status["nonvoluntary_ctxt_switches"];
+            }
+        }
+        closedir(tasks);
+    }
+
+    read_memory_and_syscalls(proc_path(pid), proc_path(pid) + "/io", usage);
+    return true;
+}
+
+/*
+ * CPU time consumed so far by the calling thread.
+ */
+inline std::chrono::nanoseconds thread_cpu_time()
+{
+    timespec ts = {};
+    (void) clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+/*
+ * Pins every thread of a process to the first cores online CPUs.
+ */
+inline bool restrict_process_cores(
+        pid_t pid,
+        size_t cores)
+{
+    long online = sysconf(_SC_NPROCESSORS_ONLN);
+    if ((0 == cores) || (long(cores) > online))
+    {
+        return false;
+    }
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (size_t i = 0; i < cores; ++i)
+    {
+        CPU_SET(i, &cpu_set);
+    }
+
+    DIR* tasks = opendir((proc_path(pid) + "/task").c_str());
+    if (nullptr == tasks)
+    {
+        return false;
+    }
+
+    bool rv = true;
+    for (dirent* entry = readdir(tasks); nullptr != entry; entry = readdir(tasks))
+    {
+        if ('.' != entry->d_name[0])
+        {
+            pid_t tid = pid_t(std::stol(entry->d_name));
+            rv = (0 == sched_setaffinity(tid, sizeof(cpu_set), &cpu_set)) && rv;
+        }
+    }
+    closedir(tasks);
+    return rv;
+}
+
+/*
+ * Reads the affinity of every thread of a process, to be restored by write_process_affinity.
+ */
+inline bool read_process_affinity(
+        pid_t pid,
+        ProcessAffinity& affinity)
+{
+    DIR* tasks = opendir((proc_path(pid) + "/task").c_str());
+    if (nullptr == tasks)
+    {
+        return false;
+    }
+
+    affinity.clear();
+    bool rv = true;
+    for (dirent* entry = readdir(tasks); nullptr != entry; entry = readdir(tasks))
+    {
+        if ('.' != entry->d_name[0])
+        {
+            pid_t tid = pid_t(std::stol(entry->d_name));
+            cpu_set_t cpu_set;
+            if (0 == sched_getaffinity(tid, sizeof(cpu_set), &cpu_set))
+            {
+                std::vector<size_t>& cpus = affinity[tid];
+                for (size_t i = 0; i < CPU_SETSIZE; ++i)
+                {
+                    if (CPU_ISSET(i, &cpu_set))
+                    {
+                        cpus.push_back(i);
+                    }
+                }
+            }
+            else
+            {
+                rv = false;
+            }
+        }
+    }
+    closedir(tasks);
+    return rv && (0 != affinity.count(pid));
+}
+
+/*
+ * Restores the affinity read by read_process_affinity. Threads started since then are given that
+ * of the main thread.
+ */
+inline bool write_process_affinity(
+        pid_t pid,
+        const ProcessAffinity& affinity)
+{
+    auto main_thread = affinity.find(pid);
+    DIR* tasks = opendir((proc_path(pid) + "/task").c_str());
+    if ((affinity.end() == main_thread) || (nullptr == tasks))
+    {
+        if (nullptr != tasks)
+        {
+            closedir(tasks);
+        }
+        return false;
+    }
+
+    bool rv = true;
+    for (dirent* entry = readdir(tasks); nullptr != entry; entry = readdir(tasks))
+    {
+        if ('.' != entry->d_name[0])
+        {
+            pid_t tid = pid_t(std::stol(entry->d_name));
+            auto thread = affinity.find(tid);
+            const std::vector<size_t>& cpus = (affinity.end() != thread) ? thread->second : main_thread->second;
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            for (auto cpu : cpus)
+            {
+                CPU_SET(cpu, &cpu_set);
+            }
+            rv = (0 == sched_setaffinity(tid, sizeof(cpu_set), &cpu_set)) && rv;
+        }
+    }
+    closedir(tasks);
+    return rv;
+}
+
+/*
+ * Applies a ThreadConfig to the calling thread. A priority the process is not permitted to use
+ * is reported once and otherwise ignored, so that unprivileged runs are still possible.
+ */
+inline void configure_current_thread(
+        const ThreadConfig& thread_config)
+{
+    if (!thread_config.cpus.empty())
+    {
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        for (auto cpu : thread_config.cpus)
+        {
+            CPU_SET(cpu, &cpu_set);
+        }
+        if (0 != pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set))
+        {
+            std::cerr << "Unable to pin a benchmark thread" << std::endl;
+        }
+    }
+
+    if (0 != thread_config.priority)
+    {
+        static std::atomic<bool> priority_warned{false};
+        sched_param param = {};
+        param.sched_priority = thread_config.priority;
+        int rv = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+        if ((0 != rv) && !priority_warned.exchange(true))
+        {
+            std::cerr << "Unable to set SCHED_FIFO priority " << thread_config.priority << ": "
+                      << std::strerror(rv) << std::endl;
+        }
+    }
+}
+
+#else
+
+/*
+ * Resource accounting and thread placement are only implemented on Linux, elsewhere nothing is
+ * measured nor placed and the runs report null usages.
+ */
+inline bool read_thread_usage(
+        ResourceUsage& usage)
+{
+    (void) usage;
+    return false;
+}
+
+inline bool read_process_usage(
+        pid_t pid,
+        ResourceUsage& usage)
+{
+    (void) pid;
+    (void) usage;
+    return false;
+}
+
+inline std::chrono::nanoseconds thread_cpu_time()
+{
+    return std::chrono::nanoseconds{0};
+}
+
+inline bool restrict_process_cores(
+        pid_t pid,
+        size_t cores)
+{
+    (void) pid;
+    (void) cores;
+    return false;
+}
+
+inline bool read_process_affinity(
+        pid_t pid,
+        ProcessAffinity& affinity)
+{
+    (void) pid;
+    (void) affinity;
+    return false;
+}
+
+inline bool write_process_affinity(
+        pid_t pid,
+        const ProcessAffinity& affinity)
+{
+    (void) pid;
+    (void) affinity;
+    return false;
+}
+
+inline void configure_current_thread(
+        const ThreadConfig& thread_config)
+{
+    static std::atomic<bool> placement_warned{false};
+    if ((!thread_config.cpus.empty() || (0 != thread_config.priority)) && !placement_warned.exchange(true))
+    {
+        std::cerr << "Thread placement is not supported on this platform" << std::endl;
+    }
+}
+
+#endif // PLATFORM_NAME_LINUX
+
+/*
+ * Runs f in a new thread placed according to thread_config.
+ */
+template<typename F>
+std::thread spawn_thread(
+        const ThreadConfig& thread_config,
+        F f)
+{
+    return std::thread([thread_config, f]()
+    {
+        configure_current_thread(thread_config);
+        f();
+    });
+}
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCESYSTEM_HPP
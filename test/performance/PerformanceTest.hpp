@@ -1,15 +1,24 @@
 #ifndef IN_TEST_PERFORMANCE_PERFORMANCETEST_HPP_
 #define IN_TEST_PERFORMANCE_PERFORMANCETEST_HPP_
 
+#include "PerformanceAgent.hpp"
+#include "PerformanceEcho.hpp"
+#include "PerformanceIngest.hpp"
+#include "PerformanceProcess.hpp"
 #include "PerformancePublisher.hpp"
+#include "PerformanceResult.hpp"
 #include "PerformanceSubscriber.hpp"
+#include "PerformanceSystem.hpp"
+#include "PerformanceTrace.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <iostream>
 #include <iomanip>
-
-static std::streambuf* default_buf = std::cout.rdbuf();
-
-constexpr size_t sep_width = 30;
+#include <memory>
+#include <sstream>
+#include <vector>
 
 constexpr uint64_t throughput[] = {
     100,
@@ -21,120 +30,1699 @@ constexpr uint64_t throughput[] = {
     100 * std::mega::num,
     1   * std::giga::num};
 
+constexpr double latency_percentiles[] = {50.0, 90.0, 99.0, 99.9, 99.99};
+
+/* Time the roles of a multi-process test have to attach, and to report a run beyond its duration. */
+constexpr std::chrono::seconds role_attach_timeout{60};
+constexpr std::chrono::seconds role_run_margin{30};
+
+/* Relative width of the [sustainable, unsustainable] rate interval at which the search stops. */
+constexpr double search_tolerance = 0.1;
+constexpr size_t search_max_trials = 12;
+
+/* Time the subscriber of an ingest run gets to request its samples, and then to receive the last ones. */
+constexpr std::chrono::milliseconds ingest_settle_time{250};
+
+/* Time without receptions after which the samples of the warm-up still in flight are taken as lost. */
+constexpr std::chrono::milliseconds warmup_drain_timeout{1000};
+
+/* Largest sample of the fragmentation sweep, which bounds the reliable buffers of both clients. */
+constexpr size_t fragmentation_max_size = 4 * 1024 * 1024;
+
+enum class TestMode : uint8_t
+{
+    THROUGHPUT,
+    PINGPONG,
+    SEARCH,
+    SCALING,
+    FRAGMENTATION,
+    BATCHING,
+    INGEST,
+    COPY
+};
+
+struct TestConfig
+{
+    std::chrono::seconds duration;
+    TestMode mode;
+    double max_loss;
+    PacerStrategy pacer;
+    ReceiveStrategy receive;
+    std::chrono::milliseconds receive_timeout;
+    std::chrono::microseconds receive_spin;
+    std::chrono::milliseconds loss_window;
+    StreamKind stream;
+    uint16_t history;
+    std::vector<size_t> sizes;
+    std::vector<size_t> mtu_multiples;
+    std::vector<size_t> batch_sizes;
+    std::chrono::nanoseconds batch_deadline;
+    uint64_t batch_throughput;
+    std::vector<size_t> pairs;
+    uint64_t pair_throughput;
+    std::vector<IngestKind> ingest_kinds;
+    std::vector<size_t> ingest_rates;
+    std::vector<WritePath> copy_paths;
+    uint64_t copy_throughput;
+    pid_t agent_pid;
+    size_t agent_cores;
+    bool embedded_agent;
+    EmbeddedAgent* agent;
+    Impairment impairment;
+    std::string capture_dir;
+    ResultFormat format;
+    ResultRecord metadata;
+    std::ostream* result_out;
+    std::ostream* histogram_out;
+    SampleTrace* trace;
+    ThreadConfig publisher_thread;
+    ThreadConfig subscriber_thread;
+    std::chrono::milliseconds warmup;
+    ProcessRole role;
+    std::string shm_name;
+};
+
+inline void add_latency_fields(
+        ResultRecord& record,
+        const std::string& prefix,
+        const LatencyHistogram& histogram)
+{
+    for (auto p : latency_percentiles)
+    {
+        std::ostringstream name;
+        name << prefix << "_p" << p;
+        record.add(name.str(), "ns", histogram.get_percentile(p));
+    }
+    record.add(prefix + "_max", "ns", histogram.get_max());
+}
+
+/*
+ * CPU cost of a run per message handled by each role: sent by the publisher, delivered to the
+ * subscriber.
+ */
+inline void add_cpu_fields(
+        ResultRecord& record,
+        std::chrono::nanoseconds pub_cpu_time,
+        uint64_t sent,
+        std::chrono::nanoseconds sub_cpu_time,
+        uint64_t delivered)
+{
+    double pub_cpu_us = double(pub_cpu_time.count()) / std::kilo::num;
+    double sub_cpu_us = double(sub_cpu_time.count()) / std::kilo::num;
+    record.add("pub_cpu_per_msg", "us", (0 != sent) ? pub_cpu_us / double(sent) : 0.0, 3);
+    record.add("sub_cpu_per_msg", "us", (0 != delivered) ? sub_cpu_us / double(delivered) : 0.0, 3);
+}
+
+inline void add_cpu_fields(
+        ResultRecord& record,
+        const PerformanceClient& publisher,
+        uint64_t sent,
+        const PerformanceClient& subscriber,
+        uint64_t delivered)
+{
+    add_cpu_fields(record, publisher.get_cpu_time(), sent, subscriber.get_cpu_time(), delivered);
+}
+
+/*
+ * Sample accounting of the subscriber, from the sequence numbers it received.
+ */
+inline void add_sequence_fields(
+        ResultRecord& record,
+        const SequenceStats& stats,
+        const WindowLoss& window_loss)
+{
+    record.add("received", "", stats.received);
+    record.add("lost", "", stats.lost);
+    record.add("duplicated", "", stats.duplicated);
+    record.add("reordered", "", stats.reordered);
+    record.add("late", "", stats.late);
+    record.add("loss_burst_max", "", stats.max_burst);
+    record.add("loss_windows", "", window_loss.windows);
+    record.add("lossy_windows", "", window_loss.lossy_windows);
+    record.add("window_loss_max", "%", window_loss.max, 3);
+    record.add("window_loss_std", "%", window_loss.std, 3);
+}
+
+inline void add_sequence_fields(
+        ResultRecord& record,
+        const SequenceTracker& tracker)
+{
+    add_sequence_fields(record, tracker.get_stats(), tracker.get_window_loss());
+}
+
+/*
+ * Resources a role used during a run. Memory is that of the process the role runs in, which the
+ * clients and an embedded Agent share.
+ */
+inline void add_usage_fields(
+        ResultRecord& record,
+        const std::string& role,
+        const ResourceUsage& usage)
+{
+    record.add(role + "_utime", "us", std::chrono::duration_cast<std::chrono::microseconds>(usage.user_time).count());
+    record.add(role + "_stime", "us", std::chrono::duration_cast<std::chrono::microseconds>(usage.system_time).count());
+    record.add(role + "_vcsw", "", usage.voluntary_switches);
+    record.add(role + "_ivcsw", "", usage.involuntary_switches);
+    record.add(role + "_syscalls", "", usage.syscalls);
+    record.add(role + "_rss_peak", "kB", usage.rss_peak);
+    record.add(role + "_rss_delta", "kB", usage.rss);
+}
+
+/*
+ * Usage of the publisher, the subscriber and, when known, the Agent.
+ */
+inline void add_role_usage_fields(
+        ResultRecord& record,
+        const ResourceUsage& pub_usage,
+        const ResourceUsage& sub_usage,
+        const TestConfig& config,
+        const ResourceUsage& agent_usage)
+{
+    add_usage_fields(record, "pub", pub_usage);
+    add_usage_fields(record, "sub", sub_usage);
+    if ((0 != config.agent_pid) || config.embedded_agent)
+    {
+        add_usage_fields(record, "agent", agent_usage);
+    }
+}
+
+inline void add_role_usage_fields(
+        ResultRecord& record,
+        const PerformanceClient& publisher,
+        const PerformanceClient& subscriber,
+        const TestConfig& config,
+        const ResourceUsage& agent_usage)
+{
+    add_role_usage_fields(record, publisher.get_usage(), subscriber.get_usage(), config, agent_usage);
+}
+
+/*
+ * Usage so far of the Agent process, an external one or the test process itself for the embedded
+ * Agent.
+ */
+inline bool read_agent_usage(
+        const TestConfig& config,
+        ResourceUsage& usage)
+{
+    if (0 != config.agent_pid)
+    {
+        return read_process_usage(config.agent_pid, usage);
+    }
+    return config.embedded_agent && read_process_usage(0, usage);
+}
+
+/*
+ * Pins the threads of the Agent, an external one or the embedded Agent, to the first cores CPUs.
+ */
+inline bool restrict_agent_cores(
+        const TestConfig& config,
+        size_t cores)
+{
+    if (0 != config.agent_pid)
+    {
+        return restrict_process_cores(config.agent_pid, cores);
+    }
+    return (nullptr != config.agent) && config.agent->restrict_cores(cores);
+}
+
+/*
+ * Reads the affinity of an external Agent before restrict_agent_cores, the embedded Agent keeping
+ * the CPUs it was started with.
+ */
+inline bool save_agent_cores(
+        const TestConfig& config,
+        ProcessAffinity& affinity)
+{
+    if (0 != config.agent_pid)
+    {
+        return read_process_affinity(config.agent_pid, affinity);
+    }
+    return nullptr != config.agent;
+}
+
+/*
+ * Undoes restrict_agent_cores, with the affinity read by save_agent_cores.
+ */
+inline bool restore_agent_cores(
+        const TestConfig& config,
+        const ProcessAffinity& affinity)
+{
+    if (0 != config.agent_pid)
+    {
+        return write_process_affinity(config.agent_pid, affinity);
+    }
+    return (nullptr != config.agent) && config.agent->restore_cores();
+}
+
+/*
+ * Reliability traffic of a run on the reliable stream, as seen by the writing and the reading
+ * client. Nothing is added on the best-effort stream.
+ */
+inline void add_stream_fields(
+        ResultRecord& record,
+        const TestConfig& config,
+        const StreamStats& writer_stats,
+        const StreamStats& reader_stats,
+        std::chrono::nanoseconds blocked_time)
+{
+    if (StreamKind::RELIABLE != config.stream)
+    {
+        return;
+    }
+    record.add("retransmissions", "", writer_stats.retransmissions + reader_stats.retransmissions);
+    record.add("heartbeats_sent", "", writer_stats.heartbeats_sent);
+    record.add("heartbeats_received", "", reader_stats.heartbeats_received);
+    record.add("acknacks_sent", "", reader_stats.acknacks_sent);
+    record.add("acknacks_received", "", writer_stats.acknacks_received);
+    record.add("blocked_time", "ns", blocked_time.count());
+}
+
+inline void add_stream_fields(
+        ResultRecord& record,
+        const TestConfig& config,
+        const PerformanceClient& writer,
+        const PerformanceClient& reader,
+        std::chrono::nanoseconds blocked_time)
+{
+    add_stream_fields(record, config, writer.get_stream_stats(), reader.get_stream_stats(), blocked_time);
+}
+
+/*
+ * Payload buffers are sized once for the largest message of the sweep, so that no run allocates.
+ */
+inline void reserve_payload(
+        PerformanceClient& client,
+        const TestConfig& config)
+{
+    size_t max_size = 0;
+    for (auto size : config.sizes)
+    {
+        max_size = (size > max_size) ? size : max_size;
+    }
+    client.reserve_payload(max_size);
+}
+
+/*
+ * Sizes above the maximum payload of the stream, a single message on the best-effort one, are
+ * reported and skipped.
+ */
+inline bool fits_payload(
+        size_t max_payload,
+        size_t size)
+{
+    if (size > max_payload)
+    {
+        std::cout << "Skipping data type size " << size << " B, above the maximum payload of "
+                  << max_payload << " B" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+inline bool fits_payload(
+        PerformanceClient& client,
+        size_t size)
+{
+    return fits_payload(client.get_max_payload(), size);
+}
+
+/*
+ * The stream configuration is only known once the client is initialized, so it is added to the
+ * metadata given by the command line here.
+ */
+inline std::unique_ptr<ResultWriter> create_writer(
+        size_t mtu,
+        uint16_t history,
+        const TestConfig& config)
+{
+    ResultRecord metadata = config.metadata;
+    metadata.add("mtu", "B", mtu);
+    metadata.add("history", "", history);
+    return ResultWriter::create(config.format, *config.result_out, metadata);
+}
+
+inline std::unique_ptr<ResultWriter> create_writer(
+        const PerformanceClient& client,
+        const TestConfig& config)
+{
+    return create_writer(client.get_mtu(), client.get_history(), config);
+}
+
+/*
+ * Transport of the n-th client of a test. Clients sharing a serial link are told apart by their
+ * local address, any other transport is shared as is.
+ */
+template<typename TF>
+TF client_transport_info(
+        const TF& transport_info,
+        size_t client_index)
+{
+    (void) client_index;
+    return transport_info;
+}
+
+#ifndef _WIN32
+template<>
+inline SerialTransportInfo client_transport_info<SerialTransportInfo>(
+        const SerialTransportInfo& transport_info,
+        size_t client_index)
+{
+    SerialTransportInfo client_info = transport_info;
+    client_info.local_addr = uint8_t(transport_info.local_addr + client_index);
+    return client_info;
+}
+#endif // _WIN32
+
 template<MiddlewareKind MK, typename TF>
 void init_test(
         PerformancePublisher<MK>& publisher,
         PerformanceSubscriber<MK>& subscriber,
-        const TF& transport_info)
+        const TestConfig& config,
+        const TF& transport_info,
+        size_t first_client = 0)
 {
-    publisher. template init<TF>(transport_info);
-    subscriber. template init<TF>(transport_info);
+    publisher.set_stream(config.stream, config.history);
+    subscriber.set_stream(config.stream, config.history);
+    publisher.set_impairment(config.impairment);
+    publisher.set_capture(config.capture_dir);
+    subscriber.set_impairment(config.impairment);
+    subscriber.set_capture(config.capture_dir);
+    subscriber.set_receive_strategy(config.receive, config.receive_timeout, config.receive_spin);
+    subscriber.set_loss_window(config.loss_window);
+    publisher. template init<TF>(client_transport_info(transport_info, first_client));
+    subscriber. template init<TF>(client_transport_info(transport_info, first_client + 1));
+}
 
-    std::cout << std::setw(sep_width) << "message_size(B)";
-    std::cout << std::setw(sep_width) << "throughput_pub(b/s)";
-    std::cout << std::setw(sep_width) << "throughput_sub(b/s)";
-    std::cout << std::setw(sep_width) << "latency(us)";
-    std::cout << std::setw(sep_width) << "jitter(us)";
-    std::cout << std::endl;
+/*
+ * Whether a run sends at least one message at the given rate, a null one being unpaced.
+ */
+inline bool sends_messages(
+        std::chrono::seconds duration,
+        size_t size,
+        uint64_t throughput)
+{
+    uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    return (0 == throughput) || (0 != throughput * ns / (std::nano::den * 8 * size));
 }
 
-template<MiddlewareKind MK, size_t S, typename D>
-void launch_test(
+/*
+ * Runs a publisher and a subscriber concurrently, each one in a thread placed as configured.
+ */
+template<MiddlewareKind MK, typename D>
+void run_pair(
         PerformancePublisher<MK>& publisher,
         PerformanceSubscriber<MK>& subscriber,
+        const TestConfig& config,
+        size_t size,
         D duration,
         uint64_t throughput)
 {
-    uint64_t ns = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
-    if (0 == throughput * ns / (std::nano::den * 8 * S))
+    std::thread publisher_thread = spawn_thread(config.publisher_thread, [&]()
+    {
+        publisher. template publish<D>(size, duration, throughput);
+    });
+    std::thread subscriber_thread = spawn_thread(config.subscriber_thread, [&]()
+    {
+        subscriber. template subscribe<D>(size, duration);
+    });
+
+    subscriber_thread.join();
+    publisher_thread.join();
+}
+
+/*
+ * Returns the number of the executed run, or 0 if the rate is too low to send a single message.
+ * A null throughput runs the publisher unpaced. The warm-up pass absorbs page faults, entity
+ * matching and cold caches; its samples are overwritten by the measured pass and never traced.
+ * The publisher flushes the warm-up, and confirms its delivery if reliable, before returning, and
+ * the subscriber then receives what is still in flight, so none of it counts in the measured pass.
+ * The usage of the Agent during the measured pass is returned in agent_usage, if given. An embedded
+ * Agent is accounted the usage of the test process minus the usage of the client threads.
+ */
+template<MiddlewareKind MK>
+uint32_t execute_test(
+        PerformancePublisher<MK>& publisher,
+        PerformanceSubscriber<MK>& subscriber,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size,
+        uint64_t throughput,
+        ResourceUsage* agent_usage = nullptr)
+{
+    using D = std::chrono::seconds;
+    D duration = config.duration;
+
+    if (!sends_messages(duration, size, throughput))
+    {
+        return 0;
+    }
+
+    if (0 < config.warmup.count())
+    {
+        subscriber.set_trace(nullptr, 0);
+        run_pair<MK>(publisher, subscriber, config, size, config.warmup, throughput);
+        (void) subscriber.drain(publisher.get_msg_count(), warmup_drain_timeout);
+    }
+
+    if (0 == throughput)
+    {
+        std::cout << "Running test with data type size " << size << " B, unpaced" << std::endl;
+    }
+    else
+    {
+        std::cout << "Running test with data type size " << size << " B, and throughput " << throughput << " bit/s" << std::endl;
+    }
+
+    uint32_t run = writer.begin_run();
+    subscriber.set_trace(config.trace, run);
+    ResourceUsage agent_begin = {};
+    bool agent = (nullptr != agent_usage) && read_agent_usage(config, agent_begin);
+    run_pair<MK>(publisher, subscriber, config, size, duration, throughput);
+
+    ResourceUsage agent_end = {};
+    if (agent && read_agent_usage(config, agent_end))
+    {
+        *agent_usage = usage_delta(agent_end, agent_begin);
+        if (0 == config.agent_pid)
+        {
+            exclude_usage(*agent_usage, publisher.get_usage());
+            exclude_usage(*agent_usage, subscriber.get_usage());
+        }
+    }
+
+    return run;
+}
+
+/*
+ * Results are filled in place, so that they can be written straight to the shared segment.
+ */
+template<MiddlewareKind MK>
+void get_run_result(
+        PerformancePublisher<MK>& publisher,
+        PublisherRunResult& result)
+{
+    result.throughput = publisher.get_throughput();
+    result.msg_count = publisher.get_msg_count();
+    result.pacing_interval = publisher.get_pacer().get_interval();
+    result.pacing_err_avg = publisher.get_pacer().get_interval_error().get_mean();
+    result.pacing_err_p99 = publisher.get_pacer().get_interval_error().get_percentile(99.0);
+    result.blocked_time = publisher.get_blocked_time();
+    result.cpu_time = publisher.get_cpu_time();
+    result.usage = publisher.get_usage();
+    result.stream = publisher.get_stream_stats();
+}
+
+template<MiddlewareKind MK>
+void get_run_result(
+        PerformanceSubscriber<MK>& subscriber,
+        SubscriberRunResult& result)
+{
+    result.throughput = subscriber.get_throughput();
+    result.msg_count = subscriber.get_msg_count();
+    result.latency_avg = subscriber.get_latency_avg();
+    result.latency_std = subscriber.get_latency_std();
+    result.histogram = subscriber.get_histogram();
+    result.sequence = subscriber.get_sequence_tracker().get_stats();
+    result.window_loss = subscriber.get_sequence_tracker().get_window_loss();
+    result.cpu_time = subscriber.get_cpu_time();
+    result.usage = subscriber.get_usage();
+    result.stream = subscriber.get_stream_stats();
+}
+
+/*
+ * Row of a throughput run, the same whether both roles run as threads or as processes.
+ */
+inline void add_throughput_fields(
+        ResultRecord& record,
+        const TestConfig& config,
+        size_t size,
+        uint64_t throughput,
+        const PublisherRunResult& pub,
+        const SubscriberRunResult& sub,
+        const ResourceUsage& agent_usage)
+{
+    record.add("message_size", "B", size);
+    record.add("throughput_pub", "b/s", pub.throughput);
+    record.add("throughput_sub", "b/s", sub.throughput);
+    record.add("latency", "ns", sub.latency_avg);
+    record.add("jitter", "ns", sub.latency_std);
+    add_latency_fields(record, "latency", sub.histogram);
+    record.add("pacing_interval", "ns", pub.pacing_interval.count());
+    record.add("pacing_err_avg", "ns", pub.pacing_err_avg);
+    record.add("pacing_err_p99", "ns", pub.pacing_err_p99);
+    record.add("offered_throughput", "b/s", throughput);
+    add_sequence_fields(record, sub.sequence, sub.window_loss);
+    add_cpu_fields(record, pub.cpu_time, pub.msg_count, sub.cpu_time, sub.msg_count);
+    add_role_usage_fields(record, pub.usage, sub.usage, config, agent_usage);
+    add_stream_fields(record, config, pub.stream, sub.stream, pub.blocked_time);
+}
+
+template<MiddlewareKind MK>
+void launch_test(
+        PerformancePublisher<MK>& publisher,
+        PerformanceSubscriber<MK>& subscriber,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size,
+        uint64_t throughput)
+{
+    ResourceUsage agent_usage = {};
+    uint32_t run = execute_test<MK>(publisher, subscriber, config, writer, size, throughput, &agent_usage);
+    if (0 == run)
     {
         return;
     }
 
-    std::streambuf* backup_buf = std::cout.rdbuf();
-    std::cout.rdbuf(default_buf);
-    std::cout << "Running test with data type size " << S << " B, and throughput " << throughput << " bit/s" << std::endl;
-    std::cout.rdbuf(backup_buf);
+    PublisherRunResult pub_result = {};
+    SubscriberRunResult sub_result = {};
+    get_run_result(publisher, pub_result);
+    get_run_result(subscriber, sub_result);
 
-    std::thread publisher_thread(
-            &PerformancePublisher<MK>:: template publish<S, D>,
-            &publisher,
-            duration,
-            throughput);
-    std::thread subscriber_thread(
-            &PerformanceSubscriber<MK>:: template subscribe<S, D>,
-            &subscriber,
-            duration);
+    ResultRecord record;
+    add_throughput_fields(record, config, size, throughput, pub_result, sub_result, agent_usage);
+    record.add("run", "", run);
+    writer.write(record);
+
+    std::ostringstream label;
+    label << "size=" << size << ",throughput=" << throughput << ",role=subscriber";
+    subscriber.get_histogram().dump(*config.histogram_out, label.str());
+    subscriber.get_sequence_tracker().dump(*config.histogram_out, label.str());
+}
+
+/*
+ * An offered rate is sustainable when the publisher actually reaches it and the subscriber
+ * receives what the publisher sent, both within the configured loss bound. Losses are those of
+ * the sequence numbers, unaffected by the runs of both roles ending at slightly different times.
+ */
+template<MiddlewareKind MK>
+bool is_sustainable(
+        PerformancePublisher<MK>& publisher,
+        PerformanceSubscriber<MK>& subscriber,
+        const TestConfig& config,
+        uint64_t throughput)
+{
+    double pub_throughput = double(publisher.get_throughput());
+    const SequenceStats& stats = subscriber.get_sequence_tracker().get_stats();
+    return (pub_throughput >= double(throughput) * (1.0 - config.max_loss))
+        && (0 != stats.received)
+        && (double(stats.lost) <= double(stats.received + stats.lost) * config.max_loss);
+}
+
+/*
+ * Ramp-and-backoff search of the saturation point. The first trial is run at the highest rate
+ * of the grid; if it is not sustainable the achieved rates bound the knee, which is then refined
+ * by bisection in logarithmic scale.
+ */
+template<MiddlewareKind MK>
+void search_test(
+        PerformancePublisher<MK>& publisher,
+        PerformanceSubscriber<MK>& subscriber,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size)
+{
+    const uint64_t min_throughput = throughput[0];
+    const uint64_t max_throughput = throughput[sizeof(throughput) / sizeof(throughput[0]) - 1];
+
+    uint64_t knee_throughput = 0;
+    uint64_t knee_pub_throughput = 0;
+    uint64_t knee_sub_throughput = 0;
+    double knee_latency_avg = 0.0;
+    LatencyHistogram knee_histogram;
+    uint32_t knee_run = 0;
+    size_t trials = 0;
+
+    auto run_trial = [&](uint64_t offered) -> bool
+    {
+        ++trials;
+        uint32_t run = execute_test<MK>(publisher, subscriber, config, writer, size, offered);
+        if (0 == run)
+        {
+            return false;
+        }
+        bool sustainable = is_sustainable(publisher, subscriber, config, offered);
+        if (sustainable && (offered > knee_throughput))
+        {
+            knee_run = run;
+            knee_throughput = offered;
+            knee_pub_throughput = publisher.get_throughput();
+            knee_sub_throughput = subscriber.get_throughput();
+            knee_latency_avg = subscriber.get_latency_avg();
+            knee_histogram = subscriber.get_histogram();
+        }
+        return sustainable;
+    };
+
+    uint64_t lo = 0;
+    uint64_t hi = max_throughput;
+    if (run_trial(max_throughput))
+    {
+        lo = max_throughput;
+    }
+    else
+    {
+        /* Ramp: the delivered rate is the first candidate, backoff until one is sustainable. */
+        uint64_t achieved = publisher.get_throughput();
+        uint64_t candidate = uint64_t(double(subscriber.get_throughput()) * (1.0 - config.max_loss));
+        hi = ((0 < achieved) && (achieved < hi)) ? achieved : hi;
+        candidate = ((min_throughput <= candidate) && (candidate < hi)) ? candidate : hi / 4;
+        while ((candidate >= min_throughput) && (trials < search_max_trials))
+        {
+            if (run_trial(candidate))
+            {
+                lo = candidate;
+                break;
+            }
+            hi = candidate;
+            candidate /= 4;
+        }
+
+        /* Bisection in logarithmic scale. */
+        while ((0 != lo) && (double(hi) > double(lo) * (1.0 + search_tolerance)) && (trials < search_max_trials))
+        {
+            uint64_t mid = uint64_t(std::sqrt(double(lo) * double(hi)));
+            if (run_trial(mid))
+            {
+                lo = mid;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+    }
+
+    ResultRecord record;
+    record.add("message_size", "B", size);
+    record.add("max_throughput", "b/s", knee_throughput);
+    record.add("throughput_pub", "b/s", knee_pub_throughput);
+    record.add("throughput_sub", "b/s", knee_sub_throughput);
+    record.add("latency_avg", "ns", knee_latency_avg);
+    add_latency_fields(record, "latency", knee_histogram);
+    record.add("trials", "", trials);
+    record.add("run", "", knee_run);
+    writer.write(record);
+
+    std::ostringstream label;
+    label << "size=" << size << ",throughput=" << knee_throughput << ",role=subscriber";
+    knee_histogram.dump(*config.histogram_out, label.str());
+}
+
+template<MiddlewareKind MK, typename TF>
+void init_pingpong_test(
+        PerformancePublisher<MK>& publisher,
+        PerformanceEcho<MK>& echo,
+        const TestConfig& config,
+        const TF& transport_info)
+{
+    publisher.set_stream(config.stream, config.history);
+    echo.set_stream(config.stream, config.history);
+    publisher.set_impairment(config.impairment);
+    publisher.set_capture(config.capture_dir);
+    echo.set_impairment(config.impairment);
+    echo.set_capture(config.capture_dir);
+    publisher. template init<TF>(client_transport_info(transport_info, 0));
+    echo. template init<TF>(client_transport_info(transport_info, 1));
+}
+
+/*
+ * Runs the ping publisher against an echo client serving it for the same time.
+ */
+template<MiddlewareKind MK, typename D>
+void run_ping(
+        PerformancePublisher<MK>& publisher,
+        PerformanceEcho<MK>& echo,
+        const TestConfig& config,
+        size_t size,
+        D duration)
+{
+    std::atomic<bool> echo_running{true};
+    std::thread echo_thread = spawn_thread(config.subscriber_thread, [&]()
+    {
+        echo.echo(echo_running);
+    });
+    std::thread publisher_thread = spawn_thread(config.publisher_thread, [&]()
+    {
+        publisher. template ping<D>(size, duration);
+    });
 
-    subscriber_thread.join();
     publisher_thread.join();
+    echo_running = false;
+    echo_thread.join();
+}
+
+template<MiddlewareKind MK>
+void launch_pingpong_test(
+        PerformancePublisher<MK>& publisher,
+        PerformanceEcho<MK>& echo,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size)
+{
+    using D = std::chrono::seconds;
+
+    if (0 < config.warmup.count())
+    {
+        publisher.set_trace(nullptr, 0);
+        run_ping<MK>(publisher, echo, config, size, config.warmup);
+    }
+
+    std::cout << "Running ping-pong test with data type size " << size << " B" << std::endl;
+
+    uint32_t run = writer.begin_run();
+    publisher.set_trace(config.trace, run);
+    run_ping<MK>(publisher, echo, config, size, D(config.duration));
+
+    const LatencyHistogram& rtt = publisher.get_rtt_histogram();
+
+    ResultRecord record;
+    record.add("message_size", "B", size);
+    record.add("pings", "", publisher.get_msg_count());
+    record.add("lost_pings", "", publisher.get_lost_count());
+    record.add("rtt_avg", "ns", rtt.get_mean());
+    add_latency_fields(record, "rtt", rtt);
+    add_stream_fields(record, config, publisher, echo, std::chrono::nanoseconds{0});
+    record.add("run", "", run);
+    writer.write(record);
+
+    std::ostringstream label;
+    label << "size=" << size << ",role=pingpong";
+    rtt.dump(*config.histogram_out, label.str());
+}
+
+template<MiddlewareKind MK, typename TF>
+void run_pingpong_middleware(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    PerformancePublisher<MK> publisher(true, config.pacer);
+    PerformanceEcho<MK> echo;
+
+    init_pingpong_test<MK>(publisher, echo, config, transport_info);
+    std::unique_ptr<ResultWriter> writer = create_writer(publisher, config);
 
-    std::cout.setf(std::ios::fixed);
-    std::cout << std::setprecision(0);
-    std::cout << std::setw(sep_width) << S;
-    std::cout << std::setw(sep_width) << publisher.get_throughput();
-    std::cout << std::setw(sep_width) << subscriber.get_throughput();
-    std::cout << std::setw(sep_width) << subscriber.get_latency_avg();
-    std::cout << std::setw(sep_width) << subscriber.get_latency_std();
-    std::cout << std::endl;
+    reserve_payload(publisher, config);
+    for (auto size : config.sizes)
+    {
+        if (fits_payload(publisher, size))
+        {
+            launch_pingpong_test<MK>(publisher, echo, config, *writer, size);
+        }
+    }
 }
 
-template<MiddlewareKind MK, size_t F, size_t ...R, typename D>
-typename std::enable_if<sizeof...(R) == 0>::type
-for_each_launch_test(
+/*
+ * Runs all the pairs of a scaling step concurrently. Every thread of a role shares the CPUs
+ * configured for it.
+ */
+template<MiddlewareKind MK, typename D>
+void run_pairs(
+        std::vector<std::unique_ptr<PerformancePublisher<MK>>>& publishers,
+        std::vector<std::unique_ptr<PerformanceSubscriber<MK>>>& subscribers,
+        const TestConfig& config,
+        size_t size,
+        D duration)
+{
+    uint64_t pair_throughput = config.pair_throughput;
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < publishers.size(); ++i)
+    {
+        PerformanceSubscriber<MK>* subscriber = subscribers[i].get();
+        PerformancePublisher<MK>* publisher = publishers[i].get();
+        threads.push_back(spawn_thread(config.subscriber_thread, [=]()
+        {
+            subscriber-> template subscribe<D>(size, duration);
+        }));
+        threads.push_back(spawn_thread(config.publisher_thread, [=]()
+        {
+            publisher-> template publish<D>(size, duration, pair_throughput);
+        }));
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/*
+ * All the pairs of a scaling step publish concurrently, each one on its own session and topic.
+ * Besides one row per pair, an aggregate row (pair 0) sums the throughputs and merges the
+ * latency histograms of all of them.
+ */
+template<MiddlewareKind MK>
+void launch_scaling_test(
+        std::vector<std::unique_ptr<PerformancePublisher<MK>>>& publishers,
+        std::vector<std::unique_ptr<PerformanceSubscriber<MK>>>& subscribers,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size,
+        size_t agent_cores)
+{
+    using D = std::chrono::seconds;
+
+    if (0 < config.warmup.count())
+    {
+        run_pairs<MK>(publishers, subscribers, config, size, config.warmup);
+    }
+
+    std::cout << "Running scaling test with " << publishers.size() << " pairs, data type size " << size << " B"
+              << std::endl;
+
+    uint32_t run = writer.begin_run();
+
+    ResourceUsage agent_begin = {};
+    ResourceUsage agent_end = {};
+    bool agent = read_agent_usage(config, agent_begin);
+    std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+    run_pairs<MK>(publishers, subscribers, config, size, D(config.duration));
+
+    std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - begin;
+    double agent_cpu_usage = 0.0;
+    if (agent && read_agent_usage(config, agent_end))
+    {
+        ResourceUsage agent_usage = usage_delta(agent_end, agent_begin);
+        if (0 == config.agent_pid)
+        {
+            for (size_t i = 0; i < publishers.size(); ++i)
+            {
+                exclude_usage(agent_usage, publishers[i]->get_usage());
+                exclude_usage(agent_usage, subscribers[i]->get_usage());
+            }
+        }
+        agent_cpu_usage = 100.0 * double((agent_usage.user_time + agent_usage.system_time).count())
+                / double(elapsed.count());
+    }
+
+    uint64_t total_pub_throughput = 0;
+    uint64_t total_sub_throughput = 0;
+    LatencyHistogram total_histogram;
+    for (size_t i = 0; i <= publishers.size(); ++i)
+    {
+        bool aggregate = (publishers.size() == i);
+        if (!aggregate)
+        {
+            total_pub_throughput += publishers[i]->get_throughput();
+            total_sub_throughput += subscribers[i]->get_throughput();
+            total_histogram.merge(subscribers[i]->get_histogram());
+        }
+
+        ResultRecord record;
+        record.add("pairs", "", publishers.size());
+        record.add("pair", "", aggregate ? 0 : i + 1);
+        record.add("agent_cores", "", agent_cores);
+        record.add("message_size", "B", size);
+        record.add("offered_throughput", "b/s", config.pair_throughput);
+        record.add("throughput_pub", "b/s", aggregate ? total_pub_throughput : publishers[i]->get_throughput());
+        record.add("throughput_sub", "b/s", aggregate ? total_sub_throughput : subscribers[i]->get_throughput());
+        add_latency_fields(record, "latency", aggregate ? total_histogram : subscribers[i]->get_histogram());
+        if ((0 != config.agent_pid) || config.embedded_agent)
+        {
+            record.add("agent_cpu", "%", agent_cpu_usage);
+        }
+        record.add("run", "", run);
+        writer.write(record);
+    }
+}
+
+/*
+ * Runs the size sweep for every number of pairs, and again for every agent core restriction.
+ * The Agent is given back its original cores once the sweep ends.
+ * The per-sample trace is single-writer, hence not recorded in this mode.
+ */
+template<MiddlewareKind MK, typename TF>
+void run_scaling_middleware(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    std::unique_ptr<ResultWriter> writer;
+    ProcessAffinity agent_affinity;
+    bool restore = (0 != config.agent_cores) && save_agent_cores(config, agent_affinity);
+    if ((0 != config.agent_cores) && !restore)
+    {
+        std::cout << "Unable to read the agent cores, they will not be restored" << std::endl;
+    }
+
+    size_t max_cores = (0 == config.agent_cores) ? 1 : config.agent_cores;
+    for (size_t cores = 1; cores <= max_cores; ++cores)
+    {
+        if ((0 != config.agent_cores) && !restrict_agent_cores(config, cores))
+        {
+            std::cout << "Unable to restrict the agent to " << cores << " cores" << std::endl;
+            continue;
+        }
+
+        for (auto pairs : config.pairs)
+        {
+            std::vector<std::unique_ptr<PerformancePublisher<MK>>> publishers;
+            std::vector<std::unique_ptr<PerformanceSubscriber<MK>>> subscribers;
+            for (size_t i = 0; i < pairs; ++i)
+            {
+                std::string suffix = "_" + std::to_string(i);
+                publishers.emplace_back(new PerformancePublisher<MK>(false, config.pacer));
+                subscribers.emplace_back(new PerformanceSubscriber<MK>());
+                publishers.back()->set_topic_suffix(suffix);
+                subscribers.back()->set_topic_suffix(suffix);
+                init_test<MK>(*publishers.back(), *subscribers.back(), config, transport_info, 2 * i);
+                reserve_payload(*publishers.back(), config);
+                reserve_payload(*subscribers.back(), config);
+            }
+
+            if (!writer)
+            {
+                writer = create_writer(*publishers.front(), config);
+            }
+
+            for (auto size : config.sizes)
+            {
+                if (fits_payload(*publishers.front(), size))
+                {
+                    launch_scaling_test<MK>(publishers, subscribers, config, *writer, size,
+                            (0 == config.agent_cores) ? 0 : cores);
+                }
+            }
+
+            for (size_t i = 0; i < pairs; ++i)
+            {
+                publishers[i]->fini();
+                subscribers[i]->fini();
+            }
+        }
+    }
+
+    if (restore && !restore_agent_cores(config, agent_affinity))
+    {
+        std::cout << "Unable to restore the agent cores" << std::endl;
+    }
+}
+
+/*
+ * Smallest power of two history, not below min_history, holding every fragment of a max_size
+ * sample plus the slot kept free by the publisher.
+ */
+inline uint16_t fragmentation_history(
+        size_t mtu,
+        size_t max_size,
+        uint16_t min_history)
+{
+    size_t fragment_payload = PerformanceClient::get_fragment_payload(mtu);
+    size_t slots = (max_size + PERFORMANCE_WRITE_DATA_OVERHEAD + fragment_payload - 1) / fragment_payload + 1;
+    uint16_t history = min_history;
+    while ((history < slots) && (history < 0x8000))
+    {
+        history = uint16_t(history * 2);
+    }
+    return history;
+}
+
+/*
+ * Unpaced reliable publication of a sample fragmented in several messages. Goodput is the payload
+ * rate delivered to the subscriber, against the rate of the messages it actually received.
+ */
+template<MiddlewareKind MK>
+void launch_fragmentation_test(
         PerformancePublisher<MK>& publisher,
         PerformanceSubscriber<MK>& subscriber,
-        D duration,
-        uint64_t throughput)
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size)
 {
-    launch_test<MK, F>(publisher, subscriber, duration, throughput);
+    ResourceUsage agent_usage = {};
+    uint32_t run = execute_test<MK>(publisher, subscriber, config, writer, size, 0, &agent_usage);
+
+    size_t fragment_payload = PerformanceClient::get_fragment_payload(publisher.get_mtu());
+    uint64_t wire_throughput = (0 < config.duration.count())
+            ? 8 * subscriber.get_stream_stats().bytes_received / uint64_t(config.duration.count())
+            : 0;
+
+    ResultRecord record;
+    record.add("message_size", "B", size);
+    record.add("fragments", "", (size + PERFORMANCE_WRITE_DATA_OVERHEAD + fragment_payload - 1) / fragment_payload);
+    record.add("goodput", "b/s", subscriber.get_throughput());
+    record.add("throughput_pub", "b/s", publisher.get_throughput());
+    record.add("wire_throughput", "b/s", wire_throughput);
+    add_latency_fields(record, "latency", subscriber.get_histogram());
+    add_latency_fields(record, "reassembly", subscriber.get_reassembly_histogram());
+    add_sequence_fields(record, subscriber.get_sequence_tracker());
+    add_cpu_fields(record, publisher, publisher.get_msg_count(), subscriber, subscriber.get_msg_count());
+    add_role_usage_fields(record, publisher, subscriber, config, agent_usage);
+    add_stream_fields(record, config, publisher, subscriber, publisher.get_blocked_time());
+    record.add("input_buffer", "B", subscriber.get_input_buffer_size());
+    record.add("run", "", run);
+    writer.write(record);
+
+    std::ostringstream label;
+    label << "size=" << size << ",role=reassembly";
+    subscriber.get_reassembly_histogram().dump(*config.histogram_out, label.str());
 }
 
-template<MiddlewareKind MK, size_t F, size_t ...R, typename D>
-typename std::enable_if<sizeof...(R) != 0>::type
-for_each_launch_test(
+/*
+ * Sizes of the fragmentation sweep are multiples of the transport MTU, up to fragmentation_max_size.
+ * The reliable stream is forced, and its history grown so that the largest sample of the sweep
+ * fits in it.
+ */
+template<MiddlewareKind MK, typename TF>
+void run_fragmentation_middleware(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    size_t mtu = PerformanceClient::get_transport_mtu<TF>();
+
+    TestConfig fragmentation_config = config;
+    fragmentation_config.stream = StreamKind::RELIABLE;
+    fragmentation_config.sizes.clear();
+    for (auto multiple : config.mtu_multiples)
+    {
+        if (multiple * mtu > fragmentation_max_size)
+        {
+            std::cout << "Skipping " << multiple << " MTUs (" << multiple * mtu << " B), above the "
+                      << fragmentation_max_size << " B bound of the fragmentation test" << std::endl;
+            continue;
+        }
+        fragmentation_config.sizes.push_back(multiple * mtu);
+    }
+    size_t max_size = 0;
+    for (auto size : fragmentation_config.sizes)
+    {
+        max_size = (size > max_size) ? size : max_size;
+    }
+    fragmentation_config.history = fragmentation_history(mtu, max_size, config.history);
+
+    PerformancePublisher<MK> publisher(false, config.pacer);
+    PerformanceSubscriber<MK> subscriber;
+
+    init_test<MK>(publisher, subscriber, fragmentation_config, transport_info);
+    std::unique_ptr<ResultWriter> writer = create_writer(publisher, fragmentation_config);
+    reserve_payload(publisher, fragmentation_config);
+    reserve_payload(subscriber, fragmentation_config);
+
+    for (auto size : fragmentation_config.sizes)
+    {
+        if (fits_payload(publisher, size))
+        {
+            launch_fragmentation_test<MK>(publisher, subscriber, fragmentation_config, *writer, size);
+        }
+    }
+}
+
+/*
+ * Samples of a run are written batch at a time, so the flushes per sample and the wait the samples
+ * spend in the stream show the cost and gain of batching. A flush does not map to a single send
+ * call, reliable ones and retransmissions included, hence the system calls of the publisher thread
+ * are reported per sample as well.
+ */
+template<MiddlewareKind MK>
+void launch_batching_test(
         PerformancePublisher<MK>& publisher,
         PerformanceSubscriber<MK>& subscriber,
-        D duration,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size,
+        size_t batch)
+{
+    publisher.set_batching(batch, config.batch_deadline);
+    ResourceUsage agent_usage = {};
+    uint32_t run = execute_test<MK>(publisher, subscriber, config, writer, size, config.batch_throughput,
+            &agent_usage);
+    publisher.set_batching(1, std::chrono::nanoseconds{0});
+    if (0 == run)
+    {
+        return;
+    }
+
+    uint64_t msg_count = publisher.get_msg_count();
+    double flushes_per_sample = (0 != msg_count) ? double(publisher.get_flush_count()) / double(msg_count) : 0.0;
+    double syscalls_per_sample = (0 != msg_count) ? double(publisher.get_usage().syscalls) / double(msg_count) : 0.0;
+
+    ResultRecord record;
+    record.add("message_size", "B", size);
+    record.add("batch", "", batch);
+    record.add("offered_throughput", "b/s", config.batch_throughput);
+    record.add("throughput_pub", "b/s", publisher.get_throughput());
+    record.add("throughput_sub", "b/s", subscriber.get_throughput());
+    record.add("flushes_per_sample", "", flushes_per_sample, 3);
+    record.add("pub_syscalls_per_sample", "", syscalls_per_sample, 3);
+    record.add("batch_wait_avg", "ns", publisher.get_batch_wait_avg().count());
+    add_latency_fields(record, "latency", subscriber.get_histogram());
+    add_sequence_fields(record, subscriber.get_sequence_tracker());
+    add_cpu_fields(record, publisher, msg_count, subscriber, subscriber.get_msg_count());
+    add_role_usage_fields(record, publisher, subscriber, config, agent_usage);
+    record.add("run", "", run);
+    writer.write(record);
+
+    std::ostringstream label;
+    label << "size=" << size << ",batch=" << batch << ",role=subscriber";
+    subscriber.get_histogram().dump(*config.histogram_out, label.str());
+    subscriber.get_sequence_tracker().dump(*config.histogram_out, label.str());
+}
+
+template<MiddlewareKind MK, typename TF>
+void run_batching_middleware(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    PerformancePublisher<MK> publisher(false, config.pacer);
+    PerformanceSubscriber<MK> subscriber;
+
+    init_test<MK>(publisher, subscriber, config, transport_info);
+    std::unique_ptr<ResultWriter> writer = create_writer(publisher, config);
+    reserve_payload(publisher, config);
+    reserve_payload(subscriber, config);
+
+    for (auto size : config.sizes)
+    {
+        if (!fits_payload(publisher, size))
+        {
+            continue;
+        }
+        for (auto batch : config.batch_sizes)
+        {
+            launch_batching_test<MK>(publisher, subscriber, config, *writer, size, batch);
+        }
+    }
+}
+
+/*
+ * Messages of the publisher session, built once, are sent straight to the Agent, so that what is
+ * measured is the cost of processing them, not the one of the client. Samples are delivered when
+ * the subscriber receives them, heartbeats when their ACKNACK comes back to the publisher.
+ */
+template<MiddlewareKind MK>
+void launch_ingest_test(
+        PerformancePublisher<MK>& publisher,
+        PerformanceSubscriber<MK>& subscriber,
+        IngestGenerator& generator,
+        const TestConfig& config,
+        ResultWriter& writer,
+        IngestKind kind,
+        size_t size,
+        uint64_t rate)
+{
+    bool samples = (IngestKind::WRITE_DATA == kind);
+    IngestMessage message;
+    bool built = samples
+            ? message.build_write_data(publisher.get_session(), publisher.get_datawriter_id(), size)
+            : message.build_heartbeat(publisher.get_session());
+    if (!built)
+    {
+        std::cerr << "Unable to build the " << get_ingest_kind_name(kind) << " message" << std::endl;
+        return;
+    }
+
+    std::cout << "Running ingest test with " << get_ingest_kind_name(kind) << " messages of " << message.size() << " B, ";
+    if (0 == rate)
+    {
+        std::cout << "unpaced" << std::endl;
+    }
+    else
+    {
+        std::cout << "at " << rate << " msg/s" << std::endl;
+    }
+
+    uint32_t run = writer.begin_run();
+    ResourceUsage agent_begin = {};
+    bool agent = read_agent_usage(config, agent_begin);
+
+    std::thread subscriber_thread;
+    if (samples)
+    {
+        subscriber.set_trace(nullptr, 0);
+        std::chrono::milliseconds subscription = config.duration + 2 * ingest_settle_time;
+        subscriber_thread = spawn_thread(config.subscriber_thread, [&]()
+        {
+            subscriber. template subscribe<std::chrono::milliseconds>(size, subscription);
+        });
+        std::this_thread::sleep_for(ingest_settle_time);
+    }
+
+    IngestResult result = generator.run(message, config.duration, rate);
+    if (samples)
+    {
+        subscriber_thread.join();
+    }
+
+    ResourceUsage sub_usage = samples ? subscriber.get_usage() : ResourceUsage{};
+    ResourceUsage agent_usage = {};
+    ResourceUsage agent_end = {};
+    if (agent && read_agent_usage(config, agent_end))
+    {
+        agent_usage = usage_delta(agent_end, agent_begin);
+        if (0 == config.agent_pid)
+        {
+            exclude_usage(agent_usage, result.usage);
+            exclude_usage(agent_usage, sub_usage);
+        }
+    }
+
+    uint64_t delivered = samples ? subscriber.get_sequence_tracker().get_stats().received : result.replies;
+    uint64_t dropped = (result.sent > delivered) ? result.sent - delivered : 0;
+    double seconds = std::chrono::duration<double>(result.elapsed).count();
+    double send_rate = (0.0 < seconds) ? double(result.sent) / seconds : 0.0;
+    double agent_rate = (0.0 < seconds) ? double(delivered) / seconds : 0.0;
+
+    ResultRecord record;
+    record.add_text("kind", get_ingest_kind_name(kind));
+    record.add("message_size", "B", message.size());
+    record.add("offered_rate", "msg/s", rate);
+    record.add("send_rate", "msg/s", send_rate, 1);
+    record.add("sent", "", result.sent);
+    record.add("send_errors", "", result.send_errors);
+    record.add("delivered", "", delivered);
+    record.add("drop", "%", (0 != result.sent) ? 100.0 * double(dropped) / double(result.sent) : 0.0, 3);
+    record.add("agent_throughput_msg", "msg/s", agent_rate, 1);
+    record.add("agent_throughput", "b/s", uint64_t(agent_rate * 8.0 * double(message.size())));
+    add_role_usage_fields(record, result.usage, sub_usage, config, agent_usage);
+    record.add("run", "", run);
+    writer.write(record);
+}
+
+/*
+ * Sweep of the ingest test: for each kind of message, every offered rate and, for samples, every
+ * size. Samples are a single message on the best-effort stream, whatever the configured one.
+ */
+template<MiddlewareKind MK, typename TF>
+void run_ingest_middleware(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    PerformancePublisher<MK> publisher(false, config.pacer);
+    PerformanceSubscriber<MK> subscriber;
+
+    init_test<MK>(publisher, subscriber, config, transport_info);
+    std::unique_ptr<ResultWriter> writer = create_writer(publisher, config);
+    reserve_payload(subscriber, config);
+
+    IngestGenerator generator(publisher.get_session().comm, config.pacer);
+    for (auto kind : config.ingest_kinds)
+    {
+        /* A heartbeat has a single size. */
+        std::vector<size_t> sizes = (IngestKind::WRITE_DATA == kind) ? config.sizes : std::vector<size_t>{0};
+        for (auto rate : config.ingest_rates)
+        {
+            for (auto size : sizes)
+            {
+                if ((IngestKind::HEARTBEAT == kind)
+                    || fits_payload(publisher.get_mtu() - PERFORMANCE_WRITE_DATA_OVERHEAD, size))
+                {
+                    launch_ingest_test<MK>(publisher, subscriber, generator, config, *writer, kind, size, rate);
+                }
+            }
+        }
+    }
+}
+
+/*
+ * Every write path is run for a size, after the in-place one, so that the copies of each path are
+ * accounted as the write time it spends beyond the in-place one. Their share is that of the whole
+ * publisher CPU time per sample, prepare and flush of the stream included. The in-place path is
+ * always measured as the reference, but only reported, and traced, when selected.
+ */
+template<MiddlewareKind MK>
+void launch_copy_test(
+        PerformancePublisher<MK>& publisher,
+        PerformanceSubscriber<MK>& subscriber,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size)
+{
+    bool in_place_selected =
+            (config.copy_paths.end() != std::find(config.copy_paths.begin(), config.copy_paths.end(), WritePath::IN_PLACE));
+    std::vector<WritePath> paths{WritePath::IN_PLACE};
+    for (auto path : config.copy_paths)
+    {
+        if (WritePath::IN_PLACE != path)
+        {
+            paths.push_back(path);
+        }
+    }
+
+    TestConfig reference_config = config;
+    reference_config.trace = nullptr;
+
+    double in_place_write_ns = 0.0;
+    for (auto path : paths)
+    {
+        bool reported = (WritePath::IN_PLACE != path) || in_place_selected;
+        std::cout << "Writing samples through the " << get_write_path_name(path) << " path"
+                  << (reported ? "" : ", as the reference") << std::endl;
+        publisher.set_write_path(path);
+        ResourceUsage agent_usage = {};
+        uint32_t run = execute_test<MK>(publisher, subscriber, reported ? config : reference_config, writer, size,
+                config.copy_throughput, &agent_usage);
+        publisher.set_write_path(WritePath::TOPIC);
+        if (0 == run)
+        {
+            return;
+        }
+
+        uint64_t msg_count = publisher.get_msg_count();
+        double publish_ns = (0 != msg_count) ? double(publisher.get_cpu_time().count()) / double(msg_count) : 0.0;
+        double write_ns = double(publisher.get_write_time_avg().count());
+        if (WritePath::IN_PLACE == path)
+        {
+            in_place_write_ns = write_ns;
+            if (!reported)
+            {
+                continue;
+            }
+        }
+        double copy_ns = (write_ns > in_place_write_ns) ? write_ns - in_place_write_ns : 0.0;
+
+        ResultRecord record;
+        record.add("message_size", "B", size);
+        record.add_text("write_path", get_write_path_name(path));
+        record.add("offered_throughput", "b/s", config.copy_throughput);
+        record.add("throughput_pub", "b/s", publisher.get_throughput());
+        record.add("throughput_sub", "b/s", subscriber.get_throughput());
+        record.add("publish_per_msg", "ns", publish_ns, 1);
+        record.add("write_per_msg", "ns", write_ns, 1);
+        record.add("copy_per_msg", "ns", copy_ns, 1);
+        record.add("copy_share", "%", (0.0 < publish_ns) ? 100.0 * copy_ns / publish_ns : 0.0, 2);
+        add_sequence_fields(record, subscriber.get_sequence_tracker());
+        add_cpu_fields(record, publisher, msg_count, subscriber, subscriber.get_msg_count());
+        add_role_usage_fields(record, publisher, subscriber, config, agent_usage);
+        record.add("run", "", run);
+        writer.write(record);
+    }
+}
+
+template<MiddlewareKind MK, typename TF>
+void run_copy_middleware(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    PerformancePublisher<MK> publisher(false, config.pacer);
+    PerformanceSubscriber<MK> subscriber;
+
+    init_test<MK>(publisher, subscriber, config, transport_info);
+    std::unique_ptr<ResultWriter> writer = create_writer(publisher, config);
+    reserve_payload(publisher, config);
+    reserve_payload(subscriber, config);
+
+    /* The in-place reference writes into the buffer of a single message, which is contiguous. */
+    for (auto size : config.sizes)
+    {
+        if (fits_payload(publisher.get_mtu() - PERFORMANCE_WRITE_DATA_OVERHEAD, size))
+        {
+            launch_copy_test<MK>(publisher, subscriber, config, *writer, size);
+        }
+    }
+}
+
+#if defined(PLATFORM_NAME_LINUX)
+/*
+ * Publisher and subscriber roles of a multi-process test, each one running its client in its own
+ * process on the commands of the coordinator. The subscriber is the second client of the test, as
+ * when both roles run as threads.
+ */
+template<MiddlewareKind MK, typename TF>
+void run_publisher_role(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    SharedChannel channel;
+    if (!channel.attach(config.shm_name, ProcessRole::PUBLISHER, role_attach_timeout))
+    {
+        std::cerr << "Unable to attach to the coordinator at '" << config.shm_name << "'" << std::endl;
+        return;
+    }
+
+    PerformancePublisher<MK> publisher(false, config.pacer);
+    publisher.set_stream(config.stream, config.history);
+    publisher.set_impairment(config.impairment);
+    publisher.set_capture(config.capture_dir);
+    publisher. template init<TF>(client_transport_info(transport_info, 0));
+    reserve_payload(publisher, config);
+
+    SharedSegment& segment = channel.get();
+    segment.max_payload = publisher.get_max_payload();
+    segment.mtu = publisher.get_mtu();
+    segment.history = publisher.get_history();
+    configure_current_thread(config.publisher_thread);
+    channel.announce();
+
+    SharedCommand command = {};
+    while (channel.wait_command(command))
+    {
+        publisher. template publish<std::chrono::nanoseconds>(size_t(command.size), command.duration,
+                command.throughput);
+        get_run_result(publisher, segment.publisher);
+        channel.complete();
+    }
+}
+
+template<MiddlewareKind MK, typename TF>
+void run_subscriber_role(
+        const TF& transport_info,
+        const TestConfig& config)
+{
+    SharedChannel channel;
+    if (!channel.attach(config.shm_name, ProcessRole::SUBSCRIBER, role_attach_timeout))
+    {
+        std::cerr << "Unable to attach to the coordinator at '" << config.shm_name << "'" << std::endl;
+        return;
+    }
+
+    PerformanceClient::skip_client_keys(1);
+    PerformanceSubscriber<MK> subscriber;
+    subscriber.set_stream(config.stream, config.history);
+    subscriber.set_impairment(config.impairment);
+    subscriber.set_capture(config.capture_dir);
+    subscriber.set_receive_strategy(config.receive, config.receive_timeout, config.receive_spin);
+    subscriber.set_loss_window(config.loss_window);
+    subscriber. template init<TF>(client_transport_info(transport_info, 1));
+    reserve_payload(subscriber, config);
+
+    SharedSegment& segment = channel.get();
+    configure_current_thread(config.subscriber_thread);
+    channel.announce();
+
+    SharedCommand command = {};
+    while (channel.wait_command(command))
+    {
+        subscriber. template subscribe<std::chrono::nanoseconds>(size_t(command.size), command.duration);
+        get_run_result(subscriber, segment.subscriber);
+        channel.complete();
+    }
+}
+
+/*
+ * Throughput run of a multi-process test, preceded by its warm-up. The roles start on the same
+ * command, as the threads of a single process do. False if they did not report the run.
+ */
+inline bool launch_process_test(
+        SharedChannel& channel,
+        const TestConfig& config,
+        ResultWriter& writer,
+        size_t size,
         uint64_t throughput)
 {
-    launch_test<MK, F>(publisher, subscriber, duration, throughput);
-    for_each_launch_test<MK, R...>(publisher, subscriber, duration, throughput);
+    if (!sends_messages(config.duration, size, throughput))
+    {
+        return true;
+    }
+
+    SharedCommand command = {};
+    command.size = size;
+    command.throughput = throughput;
+    command.duration = config.warmup;
+    if ((0 < config.warmup.count()) && !channel.run(command, command.duration + role_run_margin))
+    {
+        std::cerr << "The publisher and subscriber roles did not complete the warm-up" << std::endl;
+        return false;
+    }
+
+    if (0 == throughput)
+    {
+        std::cout << "Running test with data type size " << size << " B, unpaced" << std::endl;
+    }
+    else
+    {
+        std::cout << "Running test with data type size " << size << " B, and throughput " << throughput << " bit/s" << std::endl;
+    }
+
+    uint32_t run = writer.begin_run();
+    ResourceUsage agent_begin = {};
+    bool agent = read_agent_usage(config, agent_begin);
+    command.duration = config.duration;
+    if (!channel.run(command, command.duration + role_run_margin))
+    {
+        std::cerr << "The publisher and subscriber roles did not complete the run" << std::endl;
+        return false;
+    }
+
+    /* An embedded Agent runs in the coordinator, whose own usage is negligible. */
+    ResourceUsage agent_usage = {};
+    ResourceUsage agent_end = {};
+    if (agent && read_agent_usage(config, agent_end))
+    {
+        agent_usage = usage_delta(agent_end, agent_begin);
+    }
+
+    const SharedSegment& segment = channel.get();
+    ResultRecord record;
+    add_throughput_fields(record, config, size, throughput, segment.publisher, segment.subscriber, agent_usage);
+    record.add("run", "", run);
+    writer.write(record);
+
+    std::ostringstream label;
+    label << "size=" << size << ",throughput=" << throughput << ",role=subscriber";
+    segment.subscriber.histogram.dump(*config.histogram_out, label.str());
+    return true;
+}
+
+/*
+ * Coordinator of a multi-process test: creates the shared segment, waits for both roles and runs
+ * the throughput sweep on them, writing the results as a single-process test does.
+ */
+inline void run_coordinator(
+        const TestConfig& config)
+{
+    SharedChannel channel;
+    if (!channel.create(config.shm_name))
+    {
+        std::cerr << "Unable to create the shared-memory segment '" << config.shm_name << "'" << std::endl;
+        return;
+    }
+
+    std::cout << "Waiting for the publisher and subscriber roles at '" << config.shm_name << "'" << std::endl;
+    if (!channel.wait_attached(role_attach_timeout))
+    {
+        std::cerr << "The publisher and subscriber roles did not attach" << std::endl;
+        channel.stop();
+        return;
+    }
+
+    SharedSegment& segment = channel.get();
+    std::unique_ptr<ResultWriter> writer = create_writer(segment.mtu, segment.history, config);
+
+    bool running = true;
+    for (auto t : throughput)
+    {
+        for (auto size : config.sizes)
+        {
+            if (running && fits_payload(segment.max_payload, size))
+            {
+                running = launch_process_test(channel, config, *writer, size, t);
+            }
+        }
+    }
+    channel.stop();
 }
 
-template<MiddlewareKind MK, typename TF, typename D>
+#endif // PLATFORM_NAME_LINUX
+
+template<MiddlewareKind MK, typename TF>
 void run_test_middleware(
         const TF& transport_info,
-        D duration)
+        const TestConfig& config)
 {
-    PerformancePublisher<MK> publisher;
+#if defined(PLATFORM_NAME_LINUX)
+    if (ProcessRole::PUBLISHER == config.role)
+    {
+        run_publisher_role<MK>(transport_info, config);
+        return;
+    }
+
+    if (ProcessRole::SUBSCRIBER == config.role)
+    {
+        run_subscriber_role<MK>(transport_info, config);
+        return;
+    }
+#endif // PLATFORM_NAME_LINUX
+
+    if (TestMode::PINGPONG == config.mode)
+    {
+        run_pingpong_middleware<MK>(transport_info, config);
+        return;
+    }
+
+    if (TestMode::SCALING == config.mode)
+    {
+        run_scaling_middleware<MK>(transport_info, config);
+        return;
+    }
+
+    if (TestMode::FRAGMENTATION == config.mode)
+    {
+        run_fragmentation_middleware<MK>(transport_info, config);
+        return;
+    }
+
+    if (TestMode::BATCHING == config.mode)
+    {
+        run_batching_middleware<MK>(transport_info, config);
+        return;
+    }
+
+    if (TestMode::INGEST == config.mode)
+    {
+        run_ingest_middleware<MK>(transport_info, config);
+        return;
+    }
+
+    if (TestMode::COPY == config.mode)
+    {
+        run_copy_middleware<MK>(transport_info, config);
+        return;
+    }
+
+    PerformancePublisher<MK> publisher(false, config.pacer);
     PerformanceSubscriber<MK> subscriber;
 
-    init_test<MK>(publisher, subscriber, transport_info);
+    init_test<MK>(publisher, subscriber, config, transport_info);
+    std::unique_ptr<ResultWriter> writer = create_writer(publisher, config);
+    reserve_payload(publisher, config);
+    reserve_payload(subscriber, config);
+
+    if (TestMode::SEARCH == config.mode)
+    {
+        for (auto size : config.sizes)
+        {
+            if (fits_payload(publisher, size))
+            {
+                search_test<MK>(publisher, subscriber, config, *writer, size);
+            }
+        }
+        return;
+    }
 
     for (auto t : throughput)
     {
-        for_each_launch_test<MK, 2<<3, 2<<4, 2<<5, 2<<6, 2<<7, 2<<8, 2<<9, 2<<10, 2<<11, 2<<12, 2<<13, 2<<14, 63000>
-            (publisher, subscriber, std::chrono::seconds(duration), t);
+        for (auto size : config.sizes)
+        {
+            if (fits_payload(publisher, size))
+            {
+                launch_test<MK>(publisher, subscriber, config, *writer, size, t);
+            }
+        }
     }
 }
 
-template<typename TF, typename D>
+template<typename TF>
 void run_test(
         MiddlewareKind mk,
         const TF& transport_info,
-        D duration)
+        const TestConfig& config)
 {
+#if defined(PLATFORM_NAME_LINUX)
+    if (ProcessRole::COORDINATOR == config.role)
+    {
+        run_coordinator(config);
+        return;
+    }
+#endif // PLATFORM_NAME_LINUX
+
     switch (mk)
     {
         case MiddlewareKind::FAST:
         {
-            run_test_middleware<MiddlewareKind::FAST>(transport_info, duration);
+            run_test_middleware<MiddlewareKind::FAST>(transport_info, config);
             break;
         }
         case MiddlewareKind::CED:
         {
-            run_test_middleware<MiddlewareKind::CED>(transport_info, duration);
+            run_test_middleware<MiddlewareKind::CED>(transport_info, config);
             break;
         }
     }
@@ -3,25 +3,117 @@
 
 #include <ucdr/microcdr.h>
 
-template<size_t Size>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+/*
+ * Preallocated, cache-line aligned buffer backing the topic payload. It is sized once for the
+ * largest payload of the sweep, so that neither publication nor reception allocates.
+ */
+class PerformanceArena
+{
+public:
+    static constexpr size_t alignment = 64;
+
+    PerformanceArena()
+        : storage_{}
+        , data_{nullptr}
+        , capacity_{0}
+    {}
+
+    void reserve(
+            size_t capacity)
+    {
+        if (capacity > capacity_)
+        {
+            storage_.reset(new uint8_t[capacity + alignment - 1]);
+            uintptr_t address = reinterpret_cast<uintptr_t>(storage_.get());
+            data_ = storage_.get() + ((alignment - (address % alignment)) % alignment);
+            capacity_ = capacity;
+            std::memset(data_, 0, capacity_);
+        }
+    }
+
+    uint8_t* data() { return data_; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    std::unique_ptr<uint8_t[]> storage_;
+    uint8_t* data_;
+    size_t capacity_;
+};
+
+/*
+ * Ways a sample reaches the output stream, from the most to the least copies of its payload:
+ * - STRUCT: copied into a topic struct which owns it, as the strcpy into a generated type does,
+ *   and then serialized.
+ * - TOPIC: serialized from the buffer of the application, which the topic points to.
+ * - BLOB: serialized once ahead, then only its header patched and the whole blob copied.
+ * - IN_PLACE: the header is serialized and the payload produced straight in the stream, so never
+ *   copied, which is what a zero-copy API would allow.
+ */
+enum class WritePath : uint8_t
+{
+    STRUCT,
+    TOPIC,
+    BLOB,
+    IN_PLACE
+};
+
+inline const char* get_write_path_name(
+        WritePath path)
+{
+    switch (path)
+    {
+        case WritePath::STRUCT:
+            return "struct";
+        case WritePath::TOPIC:
+            return "topic";
+        case WritePath::BLOB:
+            return "blob";
+        case WritePath::IN_PLACE:
+            return "in_place";
+    }
+    return "";
+}
+
+/*
+ * Runtime-sized topic: a header with the sequence number of the sample in its run and its
+ * publication timestamp, followed by (size - header_size) bytes of payload which live in a
+ * PerformanceArena.
+ */
 struct PerformanceTopic
 {
+    static constexpr size_t header_size = 3 * sizeof(uint32_t);
+
+    uint32_t seq_num;
     uint32_t timestamp[2];
-    uint8_t data[Size - sizeof(timestamp)];
+    uint8_t* data;
+    size_t size;
 
     bool serialize(
-        ucdrBuffer& ub) const
+            ucdrBuffer& ub) const
+    {
+        (void) serialize_header(ub);
+        (void) ucdr_serialize_array_uint8_t(&ub, data, uint32_t(size - header_size));
+        return !ub.error;
+    }
+
+    bool serialize_header(
+            ucdrBuffer& ub) const
     {
+        (void) ucdr_serialize_uint32_t(&ub, seq_num);
         (void) ucdr_serialize_array_uint32_t(&ub, timestamp, 2);
-        (void) ucdr_serialize_array_uint8_t(&ub, data, sizeof(data));
         return !ub.error;
     }
 
     bool deserialize(
             ucdrBuffer& ub)
     {
+        (void) ucdr_deserialize_uint32_t(&ub, &seq_num);
         (void) ucdr_deserialize_array_uint32_t(&ub, timestamp, 2);
-        (void) ucdr_deserialize_array_uint8_t(&ub, data, sizeof(data));
+        (void) ucdr_deserialize_array_uint8_t(&ub, data, uint32_t(size - header_size));
         return !ub.error;
     }
 };
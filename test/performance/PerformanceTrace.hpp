@@ -0,0 +1,228 @@
+#ifndef IN_TEST_PERFORMANCE_PERFORMANCETRACE_HPP
+#define IN_TEST_PERFORMANCE_PERFORMANCETRACE_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined(PLATFORM_NAME_LINUX)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // PLATFORM_NAME_LINUX
+
+/*
+ * On-disk layout: a TraceHeader followed by sample_count TraceSample records, all little endian
+ * as written by the host. The run field matches the "run" column of the result rows.
+ */
+struct TraceHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t sample_size;
+    uint64_t sample_count;
+};
+
+struct TraceSample
+{
+    uint64_t send_ns;
+    uint64_t recv_ns;
+    uint32_t run;
+    uint32_t size;
+};
+
+#if defined(PLATFORM_NAME_LINUX)
+
+/*************************************************************************************************
+ * Sample Trace
+ *
+ * Binary per-sample trace backed by a memory-mapped file, so recording a sample is a plain store.
+ * The file is grown by doubling its mapping when full and truncated to its content on close.
+ * Recording is not synchronized: only one role may write a given trace at a time.
+ *************************************************************************************************/
+class SampleTrace
+{
+public:
+    static constexpr uint32_t version = 1;
+
+    SampleTrace()
+        : fd_{-1}
+        , base_{nullptr}
+        , capacity_{0}
+        , count_{0}
+        , dropped_{0}
+    {}
+
+    ~SampleTrace()
+    {
+        close();
+    }
+
+    SampleTrace(const SampleTrace&) = delete;
+    SampleTrace& operator = (const SampleTrace&) = delete;
+
+    bool open(
+            const std::string& path);
+
+    void close();
+
+    void record(
+            uint32_t run,
+            uint32_t size,
+            uint64_t send_ns,
+            uint64_t recv_ns)
+    {
+        if ((count_ == capacity_) && !map(2 * capacity_))
+        {
+            ++dropped_;
+            return;
+        }
+        TraceSample& sample = samples()[count_++];
+        sample.send_ns = send_ns;
+        sample.recv_ns = recv_ns;
+        sample.run = run;
+        sample.size = size;
+    }
+
+    bool is_open() const { return -1 != fd_; }
+    uint64_t get_count() const { return count_; }
+    uint64_t get_dropped() const { return dropped_; }
+
+private:
+    bool map(
+            uint64_t capacity);
+
+    void unmap();
+
+    TraceSample* samples()
+    {
+        return reinterpret_cast<TraceSample*>(static_cast<uint8_t*>(base_) + sizeof(TraceHeader));
+    }
+
+    static size_t file_size(
+            uint64_t capacity)
+    {
+        return sizeof(TraceHeader) + size_t(capacity) * sizeof(TraceSample);
+    }
+
+private:
+    int fd_;
+    void* base_;
+    uint64_t capacity_;
+    uint64_t count_;
+    uint64_t dropped_;
+};
+
+inline bool SampleTrace::open(
+        const std::string& path)
+{
+    close();
+
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+    if (-1 == fd_)
+    {
+        return false;
+    }
+
+    count_ = 0;
+    dropped_ = 0;
+    if (!map(uint64_t(1) << 20))
+    {
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    TraceHeader* header = static_cast<TraceHeader*>(base_);
+    std::memcpy(header->magic, "XRCETRC", sizeof(header->magic));
+    header->version = version;
+    header->sample_size = uint32_t(sizeof(TraceSample));
+    header->sample_count = 0;
+    return true;
+}
+
+inline void SampleTrace::close()
+{
+    if (!is_open())
+    {
+        return;
+    }
+
+    static_cast<TraceHeader*>(base_)->sample_count = count_;
+    unmap();
+    (void) ::ftruncate(fd_, off_t(file_size(count_)));
+    ::close(fd_);
+    fd_ = -1;
+}
+
+inline bool SampleTrace::map(
+        uint64_t capacity)
+{
+    /* The file only grows, so the previous mapping stays valid should the new one fail. */
+    if (0 != ::ftruncate(fd_, off_t(file_size(capacity))))
+    {
+        return false;
+    }
+
+    void* base = ::mmap(nullptr, file_size(capacity), PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (MAP_FAILED == base)
+    {
+        return false;
+    }
+
+    unmap();
+    base_ = base;
+    capacity_ = capacity;
+    return true;
+}
+
+inline void SampleTrace::unmap()
+{
+    if (nullptr != base_)
+    {
+        (void) ::munmap(base_, file_size(capacity_));
+        base_ = nullptr;
+    }
+}
+
+#else
+
+/*
+ * Sample traces are memory-mapped files, only supported on Linux. Elsewhere a trace never opens,
+ * so that no sample is recorded.
+ */
+class SampleTrace
+{
+public:
+    static constexpr uint32_t version = 1;
+
+    bool open(
+            const std::string& path)
+    {
+        (void) path;
+        return false;
+    }
+
+    void close() {}
+
+    void record(
+            uint32_t run,
+            uint32_t size,
+            uint64_t send_ns,
+            uint64_t recv_ns)
+    {
+        (void) run;
+        (void) size;
+        (void) send_ns;
+        (void) recv_ns;
+    }
+
+    bool is_open() const { return false; }
+    uint64_t get_count() const { return 0; }
+    uint64_t get_dropped() const { return 0; }
+};
+
+#endif // PLATFORM_NAME_LINUX
+
+#endif // IN_TEST_PERFORMANCE_PERFORMANCETRACE_HPP
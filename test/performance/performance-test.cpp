@@ -8,6 +8,10 @@ int main(int argc, char** argv)
 
     UDPSubcommand udp_subcommand(app);
     TCPSubcommand tcp_subcommand(app);
+#if defined(PLATFORM_NAME_LINUX)
+    SerialSubcommand serial_subcommand(app);
+    ReplaySubcommand replay_subcommand(app);
+#endif // PLATFORM_NAME_LINUX
 
     app.parse(argc, argv);
 
@@ -18,10 +18,9 @@
 class PublisherSubscriberInteraction : public ::testing::TestWithParam<std::tuple<TransportKind, float, MiddlewareKind>>
 {
 public:
-    const uint16_t AGENT_PORT = 2018;
-
     PublisherSubscriberInteraction()
     : transport_(std::get<0>(GetParam()))
+    , agent_port_(get_free_port(transport_))
     , fd_{-1}
     , middleware_{}
     , publisher_(std::get<1>(GetParam()), 8)
@@ -36,7 +35,12 @@ public:
                 middleware_ = eprosima::uxr::Middleware::Kind::CED;
                 break;
         }
-        init_agent(AGENT_PORT);
+        init_agent(agent_port_);
+
+        /* Both clients share the topics of this test only. */
+        std::string topic_suffix = get_topic_suffix();
+        publisher_.set_topic_suffix(topic_suffix);
+        subscriber_.set_topic_suffix(topic_suffix);
     }
 
     ~PublisherSubscriberInteraction() override
@@ -54,7 +58,7 @@ public:
             {
                 UDPTransportInfo transport_info;
                 transport_info.ip = "127.0.0.1";
-                transport_info.port = AGENT_PORT;
+                transport_info.port = agent_port_;
                 ASSERT_NO_FATAL_FAILURE(publisher_.init_transport<UDPTransportInfo>(transport_info));
                 ASSERT_NO_FATAL_FAILURE(subscriber_.init_transport<UDPTransportInfo>(transport_info));
                 break;
@@ -63,7 +67,7 @@ public:
             {
                 TCPTransportInfo transport_info;
                 transport_info.ip = "127.0.0.1";
-                transport_info.port = AGENT_PORT;
+                transport_info.port = agent_port_;
                 ASSERT_NO_FATAL_FAILURE(publisher_.init_transport<TCPTransportInfo>(transport_info));
                 ASSERT_NO_FATAL_FAILURE(subscriber_.init_transport<TCPTransportInfo>(transport_info));
                 break;
@@ -162,6 +166,7 @@ public:
 
 protected:
     TransportKind transport_;
+    uint16_t agent_port_;
     int fd_;
     eprosima::uxr::Middleware::Kind middleware_;
     std::unique_ptr<eprosima::uxr::Server> agent_;
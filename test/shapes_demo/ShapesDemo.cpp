@@ -41,6 +41,8 @@
 #include <uxr/agent/transport/tcp/TCPServerWindows.hpp>
 #endif
 
+#include <TestIsolation.hpp>
+
 #include <gtest/gtest.h>
 #include <cstdlib>
 
@@ -50,10 +52,10 @@
 class ShapesDemoTest : public ::testing::TestWithParam<int>
 {
 public:
-    const uint16_t AGENT_PORT = 2018;
     ShapesDemoTest()
         : transport_(GetParam())
-        , agent_(init_agent(AGENT_PORT))
+        , agent_port_(get_free_port((TCP_TRANSPORT == transport_) ? TransportKind::tcp : TransportKind::udp))
+        , agent_(init_agent(agent_port_))
     {
         agent_->run();
         agent_->load_config_file(UTEST_SHAPESDEMO_REFS);
@@ -63,7 +65,7 @@ public:
     {
         std::string echo = "echo '";
         std::string executable = UTEST_SHAPESDEMO_COMMAND;
-        std::string args = ((UDP_TRANSPORT == transport_) ? "--udp" : "--tcp") + std::string(" 127.0.0.1 ") + std::to_string(AGENT_PORT);
+        std::string args = ((UDP_TRANSPORT == transport_) ? "--udp" : "--tcp") + std::string(" 127.0.0.1 ") + std::to_string(agent_port_);
 
         std::string commands = "";
         for(std::vector<std::string>::iterator it = commands_.begin() ; it != commands_.end(); ++it)
@@ -98,6 +100,7 @@ protected:
     }
 
     int transport_;
+    uint16_t agent_port_;
     std::unique_ptr<eprosima::uxr::Server> agent_;
     std::vector<std::string> commands_;
 };